@@ -0,0 +1,149 @@
+//LOCAL IMPORTS
+#include "AnalysisCache.h"
+
+//LLVM IMPORTS
+#include "llvm/IR/DebugInfoMetadata.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/raw_ostream.h"
+
+//STL IMPORTS
+#include <fstream>
+#include <sstream>
+
+// Bump whenever the analysis or the entry format changes
+#define CACHE_VERSION "dep-analysis-cache 3"
+
+std::string AnalysisCache::computeKey(Function &F, std::string context)
+{
+	std::string ir;
+	raw_string_ostream irStream(ir);
+	irStream << CACHE_VERSION << "\n";
+	F.print(irStream);
+	// Debug locations are only referenced by the printed IR
+	for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I)
+	{
+		if (DebugLoc dl = I->getDebugLoc())
+		{
+			irStream << dl.getLine() << ":" << dl.getCol() << ":"
+				<< cast<DIScope>(dl.getScope())->getFilename() << "\n";
+		}
+		else
+		{
+			irStream << "-\n";
+		}
+	}
+	irStream << context;
+
+	MD5 hash;
+	hash.update(irStream.str());
+	MD5::MD5Result result;
+	hash.final(result);
+	return result.digest().str().str();
+}
+
+std::string AnalysisCache::entryPath(std::string key)
+{
+	return directory + "/" + key + ".depcache";
+}
+
+bool AnalysisCache::Entry::isValid(unsigned numInstructions, unsigned numBlocks) const
+{
+	if (numInstructions != this->numInstructions || numBlocks != this->numBlocks)
+		return false;
+	for (auto &pair : omissions)
+		if (pair.first >= numInstructions) return false;
+	for (auto &edge : edges)
+		if (get<0>(edge) >= numInstructions || get<1>(edge) >= numInstructions) return false;
+	for (auto &pair : conditionalDeps)
+		if (pair.first >= numBlocks) return false;
+	for (auto &pair : loopInvariant)
+		if (pair.first >= numInstructions) return false;
+	for (auto &pair : ranges)
+		if (pair.first >= numInstructions) return false;
+	for (auto &pair : redundant)
+		if (pair.first >= numInstructions || pair.second >= numInstructions) return false;
+	return true;
+}
+
+bool AnalysisCache::load(std::string key, Entry &entry)
+{
+	ifstream stream(entryPath(key));
+	if (!stream.is_open())
+		return false;
+
+	string line, tag, text;
+	unsigned a, b, c;
+	if (!getline(stream, line) || line != CACHE_VERSION)
+		return false;
+	while (getline(stream, line))
+	{
+		istringstream fields(line);
+		fields >> tag;
+		if (tag == "END")
+			return true;
+		else if (tag == "N")
+			fields >> entry.numInstructions >> entry.numBlocks;
+		else if (tag == "O" && fields >> a >> b)
+			entry.omissions[a] = b;
+		else if (tag == "E" && fields >> a >> b >> c)
+			entry.edges.push_back(make_tuple(a, b, c));
+		else if (tag == "D" && fields >> a >> b)
+			entry.redundant[a] = b;
+		else if ((tag == "C" || tag == "L" || tag == "R") && fields >> a && fields.get() == ' ' && getline(fields, text))
+		{
+			if (tag == "C") entry.conditionalDeps[a].insert(text);
+			else if (tag == "L") entry.loopInvariant[a] = text;
+			else entry.ranges[a] = text;
+		}
+		else
+			return false;
+	}
+	// Truncated entry
+	return false;
+}
+
+bool AnalysisCache::store(std::string key, const Entry &entry)
+{
+	if (sys::fs::create_directories(directory))
+		return false;
+
+	int fd;
+	SmallString<128> tmpPath;
+	if (sys::fs::createUniqueFile(directory + "/" + key + "-%%%%%%%%.tmp", fd, tmpPath))
+		return false;
+	{
+		raw_fd_ostream stream(fd, true);
+		stream << CACHE_VERSION << "\n";
+		stream << "N " << entry.numInstructions << " " << entry.numBlocks << "\n";
+		for (auto &pair : entry.omissions)
+			stream << "O " << pair.first << " " << pair.second << "\n";
+		for (auto &edge : entry.edges)
+			stream << "E " << get<0>(edge) << " " << get<1>(edge) << " " << get<2>(edge) << "\n";
+		for (auto &pair : entry.conditionalDeps)
+			for (auto &dep : pair.second)
+				stream << "C " << pair.first << " " << dep << "\n";
+		for (auto &pair : entry.loopInvariant)
+			stream << "L " << pair.first << " " << pair.second << "\n";
+		for (auto &pair : entry.ranges)
+			stream << "R " << pair.first << " " << pair.second << "\n";
+		for (auto &pair : entry.redundant)
+			stream << "D " << pair.first << " " << pair.second << "\n";
+		stream << "END\n";
+		stream.close();
+		if (stream.has_error())
+		{
+			stream.clear_error();
+			sys::fs::remove(tmpPath);
+			return false;
+		}
+	}
+	// Atomic replace: concurrent writers of the same key write identical entries
+	if (sys::fs::rename(tmpPath, entryPath(key)))
+	{
+		sys::fs::remove(tmpPath);
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,57 @@
+#ifndef ANALYSIS_CACHE_H
+#define ANALYSIS_CACHE_H
+
+//LLVM IMPORTS
+#include "llvm/IR/Function.h"
+
+//STL IMPORTS
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace llvm;
+using namespace std;
+
+// On-disk cache of per-function analysis results. Entries are addressed by a
+// hash of the function's IR, its debug locations and an analysis context
+// (options and facts from outside the function). Instructions and blocks are
+// stored by their position in the function.
+//
+// Entries are written to a unique temporary file first and then renamed into
+// place, so concurrent build jobs never see partially written entries.
+class AnalysisCache
+{
+private:
+	std::string directory;
+
+	std::string entryPath(std::string key);
+
+public:
+	struct Entry
+	{
+		unsigned numInstructions = 0;
+		unsigned numBlocks = 0;
+		map<unsigned, unsigned> omissions;
+		vector<tuple<unsigned, unsigned, unsigned>> edges;
+		map<unsigned, set<string>> conditionalDeps;
+		map<unsigned, string> loopInvariant;
+		map<unsigned, string> ranges;
+		map<unsigned, unsigned> redundant;
+
+		// Whether all indices fit a function of the given size
+		bool isValid(unsigned numInstructions, unsigned numBlocks) const;
+	};
+
+	AnalysisCache(std::string dir)
+		: directory(dir)
+		{}
+
+	static std::string computeKey(Function &F, std::string context);
+
+	bool load(std::string key, Entry &entry);
+	bool store(std::string key, const Entry &entry);
+};
+
+#endif // ANALYSIS_CACHE_H
@@ -0,0 +1,191 @@
+//LOCAL IMPORTS
+#include "DPDepFile.h"
+
+//LLVM IMPORTS
+#include "llvm/ADT/StringExtras.h"
+
+//STL IMPORTS
+#include <algorithm>
+#include <queue>
+
+bool DPDepRecord::parseLocation(StringRef text, unsigned &file, unsigned &line)
+{
+	StringRef fileText, lineText;
+	std::tie(fileText, lineText) = text.split(':');
+	return !fileText.getAsInteger(10, file) && !lineText.getAsInteger(10, line);
+}
+
+bool DPDepRecord::parse(StringRef text, DPDepRecord &record)
+{
+	record = DPDepRecord();
+	StringRef location, kind, rest;
+	std::tie(location, rest) = getToken(text);
+	std::tie(kind, rest) = getToken(rest);
+	if (kind.empty() || !parseLocation(location, record.file, record.line))
+		return false;
+	record.kind = kind.str();
+	if (record.isNOM())
+	{
+		StringRef type, source;
+		while (true)
+		{
+			std::tie(type, rest) = getToken(rest);
+			if (type.empty())
+				break;
+			std::tie(source, rest) = getToken(rest);
+			if (source.empty())
+				return false;
+			record.deps.insert((type + " " + source).str());
+		}
+	}
+	else
+	{
+		record.rest = rest.trim().str();
+	}
+	return true;
+}
+
+void DPDepRecord::print(raw_ostream &os) const
+{
+	os << file << ":" << line << " " << kind;
+	if (isNOM())
+	{
+		os << " ";
+		for (const string &dep : deps)
+			os << " " << dep;
+	}
+	else if (!rest.empty())
+	{
+		os << " " << rest;
+	}
+	os << "\n";
+}
+
+DPDepVectorSource::DPDepVectorSource(std::vector<DPDepRecord> records)
+	: records(std::move(records))
+{
+	if (!std::is_sorted(this->records.begin(), this->records.end()))
+		std::stable_sort(this->records.begin(), this->records.end());
+}
+
+bool DPDepVectorSource::next(DPDepRecord &record)
+{
+	if (pos == records.size())
+		return false;
+	record = std::move(records[pos++]);
+	return true;
+}
+
+std::vector<DPDepRecord> toDPDepRecords(const map<string, set<string>> &depMap)
+{
+	std::vector<DPDepRecord> records;
+	for (auto &pair : depMap)
+	{
+		DPDepRecord record;
+		if (!DPDepRecord::parseLocation(pair.first, record.file, record.line))
+			continue;
+		record.kind = "NOM";
+		record.deps = pair.second;
+		records.push_back(std::move(record));
+	}
+	std::stable_sort(records.begin(), records.end());
+	return records;
+}
+
+DPDepFileSource::DPDepFileSource(const std::string &fileName)
+	: fileName(fileName)
+	, stream(fileName)
+{
+}
+
+bool DPDepFileSource::next(DPDepRecord &record)
+{
+	string text;
+	while (getline(stream, text))
+	{
+		++lineNumber;
+		if (DPDepRecord::parse(text, record))
+			return true;
+		if (!StringRef(text).trim().empty())
+			errs() << fileName << ":" << lineNumber << ": not a dependence line, skipped\n";
+	}
+	return false;
+}
+
+bool readDPDepFile(const std::string &fileName, std::vector<DPDepRecord> &records)
+{
+	DPDepFileSource source(fileName);
+	if (!source.isOpen())
+		return false;
+	DPDepRecord record;
+	while (source.next(record))
+		records.push_back(std::move(record));
+	return true;
+}
+
+// Writes the records of one location
+static uint64_t writeLocation(std::vector<DPDepRecord> &group, raw_ostream &out)
+{
+	DPDepRecord *nom = nullptr;
+	for (DPDepRecord &record : group)
+	{
+		if (!record.isNOM())
+			continue;
+		if (!nom)
+			nom = &record;
+		else
+			nom->deps.insert(record.deps.begin(), record.deps.end());
+	}
+	uint64_t lines = 0;
+	for (DPDepRecord &record : group)
+	{
+		if (record.isNOM() && &record != nom)
+			continue;
+		record.print(out);
+		++lines;
+	}
+	return lines;
+}
+
+uint64_t mergeDPDeps(const std::vector<DPDepSource*> &sources, raw_ostream &out)
+{
+	// The next record of each source, ordered by location and then source
+	struct Head
+	{
+		DPDepRecord record;
+		size_t source;
+	};
+	auto later = [](const Head *a, const Head *b)
+	{
+		if (a->record.sameLocation(b->record))
+			return a->source > b->source;
+		return b->record < a->record;
+	};
+	std::vector<Head> heads(sources.size());
+	std::priority_queue<Head*, std::vector<Head*>, decltype(later)> queue(later);
+	for (size_t i = 0; i < sources.size(); ++i)
+	{
+		heads[i].source = i;
+		if (sources[i]->next(heads[i].record))
+			queue.push(&heads[i]);
+	}
+
+	uint64_t lines = 0;
+	std::vector<DPDepRecord> group;
+	while (!queue.empty())
+	{
+		Head *head = queue.top();
+		queue.pop();
+		if (!group.empty() && !group.front().sameLocation(head->record))
+		{
+			lines += writeLocation(group, out);
+			group.clear();
+		}
+		group.push_back(std::move(head->record));
+		if (sources[head->source]->next(head->record))
+			queue.push(head);
+	}
+	if (!group.empty())
+		lines += writeLocation(group, out);
+	return lines;
+}
@@ -0,0 +1,104 @@
+#ifndef DP_DEP_FILE_H
+#define DP_DEP_FILE_H
+
+//LLVM IMPORTS
+#include "llvm/Support/raw_ostream.h"
+
+//STL IMPORTS
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace llvm;
+using namespace std;
+
+// One line of a DiscoPoP dependence file:
+//
+//   <fileID>:<line> NOM  RAW 1:4|x WAR 1:6|y
+//   <fileID>:<line> BGN loop
+//
+// The dependences of NOM lines are kept as a set, so lines of the same
+// location can be unioned. Other kinds (BGN, END, ...) keep the rest of the
+// line as it is.
+struct DPDepRecord
+{
+	unsigned file = 0;
+	unsigned line = 0;
+	std::string kind;
+	std::set<std::string> deps;  // NOM: "RAW 1:4|x"
+	std::string rest;            // other kinds
+
+	bool isNOM() const { return kind == "NOM"; }
+
+	// Numeric file, line order
+	bool operator<(const DPDepRecord &other) const
+	{
+		return std::tie(file, line) < std::tie(other.file, other.line);
+	}
+	bool sameLocation(const DPDepRecord &other) const
+	{
+		return file == other.file && line == other.line;
+	}
+
+	// Parses "<fileID>:<line>"
+	static bool parseLocation(StringRef text, unsigned &file, unsigned &line);
+	// Returns false if text is not a dependence line
+	static bool parse(StringRef text, DPDepRecord &record);
+	void print(raw_ostream &os) const;
+};
+
+// A sequence of records in location order
+class DPDepSource
+{
+public:
+	virtual ~DPDepSource() {}
+	// Returns false at the end
+	virtual bool next(DPDepRecord &record) = 0;
+};
+
+class DPDepVectorSource : public DPDepSource
+{
+private:
+	std::vector<DPDepRecord> records;
+	size_t pos = 0;
+
+public:
+	// Sorts the records if they are not in location order yet, keeping the
+	// order of records of the same location
+	DPDepVectorSource(std::vector<DPDepRecord> records);
+	bool next(DPDepRecord &record) override;
+};
+
+// Streams a dependence file without loading it. Lines that are not
+// dependence lines are skipped with a warning
+class DPDepFileSource : public DPDepSource
+{
+private:
+	std::string fileName;
+	std::ifstream stream;
+	unsigned lineNumber = 0;
+
+public:
+	DPDepFileSource(const std::string &fileName);
+	bool isOpen() const { return stream.is_open(); }
+	bool next(DPDepRecord &record) override;
+};
+
+// Records of the location keyed map returned by PDG::getDPDepMap()
+std::vector<DPDepRecord> toDPDepRecords(const map<string, set<string>> &depMap);
+
+// Reads a dependence file, e.g. a dynamic profile. Lines that are not
+// dependence lines are skipped with a warning. Returns false if the file
+// can't be opened
+bool readDPDepFile(const std::string &fileName, std::vector<DPDepRecord> &records);
+
+// K-way merge of the sources into one dependence file. The records of a
+// location are written together, in source order, except that all NOM
+// records of the location become one with the union of their dependences.
+// Returns the number of written lines
+uint64_t mergeDPDeps(const std::vector<DPDepSource*> &sources, raw_ostream &out);
+
+#endif // DP_DEP_FILE_H
@@ -14,6 +14,7 @@
 
 
 #include "llvm/Support/CommandLine.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/IR/Function.h"
 #include "llvm/Pass.h"
@@ -30,12 +31,27 @@
 #include "llvm/IR/DebugInfoMetadata.h"
 #include "PDG.h"
 #include "Graph.hpp"
+#include "FunctionSummary.h"
+#include "AnalysisCache.h"
+#include "DepAnalysis.h"
+#include "OutputWriter.h"
+#include "DPDepFile.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/DebugLoc.h"
 #include "llvm/Analysis/CallGraph.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/CaptureTracking.h"
+#include "llvm/IR/Operator.h"
 
 #include "llvm/IR/IRBuilder.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/Regex.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Transforms/Utils/ModuleUtils.h"
 
+#include <chrono>
 #include <fstream>
 // #include "llvm/ADT/Statistic.h"
 // #include "llvm/Analysis/MemorySSA.h"
@@ -48,14 +64,82 @@ using namespace llvm;
 
 STATISTIC(instrCount, "Total Store/Load Instructions");
 STATISTIC(iinstrCount, "Disregardable Store/Load Instructions");
+STATISTIC(daQueryCount, "DependenceAnalysis queries");
+STATISTIC(cfgNodeCount, "Store/Load-CFG nodes");
+STATISTIC(cfgEdgeCount, "Store/Load-CFG edges");
+STATISTIC(depEdgeCount, "Dependence edges");
+STATISTIC(visitedNodeCount, "CFG nodes visited by the dependence search");
+STATISTIC(outputByteCount, "Bytes of graphs and reports written");
+STATISTIC(budgetExceededCount, "Functions that exceeded the analysis budget");
+
+static cl::opt<bool, false> dumpBinary("dumpBinary", cl::desc("Also write the graphs in the binary PDG format (.pdg)"), cl::NotHidden);
+static cl::opt<string> depFunctions("depFunctions", cl::desc("Only analyze functions whose name matches this regex"), cl::value_desc("regex"));
+static cl::opt<bool, false> omitLoopIndependent("omitLoopIndependent", cl::desc("Omit accesses of local variables that only have loop-independent dependences"), cl::NotHidden);
+static cl::opt<string> depStatsJson("depStatsJson", cl::desc("Write per-function phase times and counters as JSON"), cl::value_desc("filename"));
+static cl::opt<string> depDumpResults("depDumpResults", cl::desc("Write the omissions, edges and DiscoPoP dependences in a canonical, sorted form"), cl::value_desc("filename"));
+static cl::opt<string> depCheckGolden("depCheckGolden", cl::desc("Fail if the canonical results differ from this file (see -depDumpResults)"), cl::value_desc("filename"));
+static cl::opt<double> depPerfMaxSeconds("depPerfMaxSeconds", cl::desc("Fail if the analysis of the module takes longer, output excluded (0 = no check)"), cl::init(0));
+static cl::opt<unsigned> depPerfMaxQueries("depPerfMaxQueries", cl::desc("Fail if the module needs more DependenceAnalysis queries (0 = no check)"), cl::init(0));
+static cl::opt<double> depBudgetSeconds("depBudgetSeconds", cl::desc("Per-function wall time budget of the analysis (0 = unlimited)"), cl::init(0));
+static cl::opt<unsigned> depBudgetQueries("depBudgetQueries", cl::desc("Per-function budget of DependenceAnalysis queries (0 = unlimited)"), cl::init(0));
+static cl::opt<unsigned> depBudgetNodes("depBudgetNodes", cl::desc("Per-function budget of nodes visited by the dependence search (0 = unlimited)"), cl::init(0));
+static cl::opt<unsigned> depOutputQueue("depOutputQueue", cl::desc("Graphs and reports queued for the background writer (0 = write them synchronously)"), cl::init(8));
+static cl::opt<bool, false> instrumentBlockCounters("instrumentBlockCounters", cl::desc("Count the entries of the blocks in <function>_blockdeps.txt"), cl::NotHidden);
+static cl::opt<string> depExport("depExport", cl::desc("Write the DiscoPoP dependences of all analyzed functions to one file"), cl::value_desc("filename"));
+static cl::opt<string> depExportMerge("depExportMerge", cl::desc("Dependence file, e.g. a dynamic profile, merged into -depExport"), cl::value_desc("filename"));
+static cl::opt<string> depCacheDir("depCacheDir", cl::desc("Directory caching the per-function analysis results"), cl::value_desc("directory"));
+
+static double phaseTimes[NUM_PHASES];
 
 namespace {
-  string edgeLabel(Edge<Instruction*, EdgeDepType> *e)
+  // Adds the wall-clock time of its scope to a phase, and reports it in the
+  // "dep-analysis" group of -time-passes
+  struct PhaseTimer {
+    DepAnalysisPhase phase;
+    NamedRegionTimer region;
+    std::chrono::steady_clock::time_point start;
+
+    PhaseTimer(DepAnalysisPhase phase)
+      : phase(phase)
+      , region(getPhaseName(phase), getPhaseName(phase), "dep-analysis", "DepAnalysis phases", TimePassesIsEnabled)
+      , start(std::chrono::steady_clock::now()) {}
+    ~PhaseTimer() {
+      phaseTimes[phase] += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+  };
+
+  // Why a store/load does not need to be instrumented
+  enum OmissionReason {
+    NODBG,        // no debug location, not instrumented by DiscoPoP anyways
+    LOCAL,        // local variable that is never written
+    CONDITIONAL,  // dependences are known statically (conditionalDepMap)
+    REDUNDANT,    // address already accessed earlier, no intervening write
+    READONLY,     // global that is constant or never written
+    LOOPINDEP     // no loop-carried dependences (-omitLoopIndependent)
+  };
+
+  string omissionLabel(OmissionReason r)
+{
+	switch (r)
+	{
+		case OmissionReason::NODBG: return "nodbg";
+		case OmissionReason::LOCAL: return "local";
+		case OmissionReason::CONDITIONAL: return "conditional";
+		case OmissionReason::REDUNDANT: return "redundant";
+		case OmissionReason::READONLY: return "readonly-global";
+		case OmissionReason::LOOPINDEP: return "loop-independent";
+		default: return std::to_string(r);
+	}
+}
+
+  string edgeLabel(const Edge<Instruction*, EdgeDepType> &e)
 {
-	switch (e->getType())
+	switch (e.getType())
 	{
 		case EdgeDepType::RAR: return "RAR";
 		case EdgeDepType::RAWLC: return "RAW*";
+		case EdgeDepType::WARLC: return "WAR*";
+		case EdgeDepType::WAWLC: return "WAW*";
 		case EdgeDepType::WAW: return "WAW";
 		case EdgeDepType::RAW: return "RAW";
 		case EdgeDepType::WAR: return "WAR";
@@ -63,44 +147,528 @@ namespace {
 		case EdgeDepType::PARENT: return "PARENT";
 		case EdgeDepType::SCA:
 		{
-			if (e->getSrc()->getItem()->hasName())
-				return e->getSrc()->getItem()->getName();
+			if (e.getSrc()->getItem()->hasName())
+				return e.getSrc()->getItem()->getName();
 			else
 				return "SCA";
 		}
-		default: return std::to_string(e->getType());
+		default: return std::to_string(e.getType());
 	}
 }
 
+  // Like the default capture tracking, but calls into functions with a summary
+  // only capture the arguments the summary says they capture
+  struct SummaryCaptureTracker : public CaptureTracker {
+    FunctionSummaryPass *FS;
+    bool Captured;
+
+    SummaryCaptureTracker(FunctionSummaryPass *FS) : FS(FS), Captured(false) {}
+
+    void tooManyUses() override { Captured = true; }
+
+    bool captured(const Use *U) override {
+      if(const CallBase *call = dyn_cast<CallBase>(U->getUser())){
+        if(isa<DbgInfoIntrinsic>(call))
+          return false;
+        if(call->isArgOperand(U) && !FS->callMayCaptureArg(call, call->getArgOperandNo(U)))
+          return false;
+      }
+      Captured = true;
+      return true;
+    }
+  };
+
+  // Per-function counters for -depStatsJson, summed up in the STATISTICs
+  struct FunctionStats {
+    string name;
+    bool cached = false;
+    string budgetExceeded;  // which budget, empty if none
+    string outputKey;       // OutputWriter key of the function's files
+    unsigned daQueries = 0;
+    unsigned cfgNodes = 0;
+    unsigned cfgEdges = 0;
+    unsigned depEdges = 0;
+    unsigned visitedNodes = 0;
+    uint64_t outputBytes = 0;
+    double phaseTimes[NUM_PHASES] = {};
+  };
+
+  // Per-function results of the omission analysis
+  struct OmissionResult {
+    map<Instruction*, OmissionReason> omittableInstructions;
+    map<BasicBlock*, set<string>> conditionalDepMap;
+    map<Instruction*, string> loopInvariantInstructions;  // -> loopLine|tripCount
+    map<Instruction*, string> rangeInstructions;          // -> base|stride|tripCount
+    map<Instruction*, Instruction*> redundantInstructions; // -> leading access
+  };
+
   struct DepAnalysis : public FunctionPass {
     static char ID;
     DependenceInfo *DI;
+    FunctionSummaryPass *FS;
     PDG *DG, *CFG;
+    FunctionStats Stats;
+    vector<FunctionStats> allStats;
+    vector<string> resultLines;
+    vector<vector<DPDepRecord>> exportRuns;  // per function, for -depExport
+    unsigned moduleQueries = 0;
+    unsigned functionCount = 0;
+    std::unique_ptr<OutputWriter> writer;
+    // Registers the arrays of addBlockCounters, see createBlockCountersCtor
+    Function *blockCountersCtor = nullptr;
+    // Part of the cache context shared by all functions of the module
+    string moduleCacheContext;
+    std::chrono::steady_clock::time_point analysisStart;
 
     DepAnalysis() : FunctionPass(ID) {}
 
-    void getAnalysisUsage(AnalysisUsage &AU) const {
-      AU.setPreservesAll();
+    void getAnalysisUsage(AnalysisUsage &AU) const override {
+      if(instrumentBlockCounters){
+        // The counters are only touched by the instrumentation, so the
+        // summaries stay valid for the analysis of the callers
+        AU.setPreservesCFG();
+        AU.addPreserved<FunctionSummaryPass>();
+        AU.addPreserved<CallGraphWrapperPass>();
+      }else{
+        AU.setPreservesAll();
+      }
       
       AU.addRequired<DominatorTreeWrapperPass>();
       AU.addRequired<PostDominatorTreeWrapperPass>();
       AU.addRequired<DependenceAnalysisWrapperPass>();
       AU.addRequired<DominatorTreeWrapperPass>();
       AU.addRequired<CallGraphWrapperPass>();
+      AU.addRequired<LoopInfoWrapperPass>();
+      AU.addRequired<ScalarEvolutionWrapperPass>();
+      AU.addRequired<AAResultsWrapperPass>();
+      AU.addRequired<FunctionSummaryPass>();
       //AU.addRequired<RegionInfoPass>();
     }
 
-    bool runOnFunction(Function &F) {
-      /*
-      if(F.getName() != "fft_twiddle_gen1"){
+    bool runOnFunction(Function &F) override {
+      if(!isSelectedFunction(F.getName()) || &F == blockCountersCtor){
         return false;
       }
-      */
       errs() << "\n---------- Omission Analysis on " << F.getName() << " (" << (isRecursive(&F)) << ") ----------\n";
 
       DebugLoc dl;
-      set<Instruction*> omittableInstructions;
-      set<Value*> localValues, writtenValues;
+      OmissionResult R;
+      FS = &getAnalysis<FunctionSummaryPass>();
+      DI = &getAnalysis<DependenceAnalysisWrapperPass>().getDI();
+      Stats = FunctionStats();
+      Stats.name = F.getName().str();
+      Stats.outputKey = to_string(functionCount++);
+      for(unsigned p = 0; p < NUM_PHASES; ++p)
+        Stats.phaseTimes[p] = -getPhaseTime((DepAnalysisPhase)p);
+      analysisStart = std::chrono::steady_clock::now();
+
+      errs() << "\tBuilding DepGraph\n";
+      DG = new PDG(F.getName(), &F);
+      CFG = new PDG(F.getName(), &F);
+      {
+        PhaseTimer T(PHASE_CFG);
+        buildCFG(F);
+      }
+      Stats.cfgNodes = CFG->size();
+      Stats.cfgEdges = CFG->getEdges().size();
+
+      string cacheKey;
+      if(!depCacheDir.empty()){
+        cacheKey = AnalysisCache::computeKey(F, getCacheContext(F));
+      }
+      Stats.cached = !cacheKey.empty() && loadFromCache(F, cacheKey, R);
+      if(!Stats.cached){
+        set<Value*> localValues;
+        {
+          PhaseTimer T(PHASE_ESCAPE);
+          findLocalOmissions(F, R, localValues);
+        }
+        {
+          PhaseTimer T(PHASE_DEPS);
+          recursiveDepFinder();
+        }
+        {
+          PhaseTimer T(PHASE_OMISSION);
+          if(!overBudget())
+            findConditionalOmissions(F, R, localValues);
+          // Loads of loop-invariant, loop-unmodified addresses only need to be
+          // instrumented once per loop entry (see findLoopInvariantAccesses)
+          if(!overBudget())
+            findLoopInvariantAccesses(F, R);
+          // Strided array accesses whose dependences are decidable are summarized as
+          // ranges instead of being instrumented per element (see findAffineRangeAccesses)
+          if(!overBudget())
+            findAffineRangeAccesses(F, R);
+          // Repeated reads of an address that is still available are omitted
+          if(!overBudget())
+            findRedundantAccesses(F, R);
+          // Dependences that are not loop-carried don't matter for parallelism discovery
+          if(omitLoopIndependent && !overBudget())
+            findLoopIndependentOmissions(F, R, localValues);
+        }
+        if(overBudget()){
+          // Results are incomplete, fall back to instrumenting every access.
+          // They are not cached, so a later run with a larger budget redoes them
+          errs() << "\tBudget exceeded (" << Stats.budgetExceeded << "), instrumenting all accesses of " << F.getName() << "\n";
+          ++budgetExceededCount;
+          dropOmissions(R);
+        }else if(!cacheKey.empty()){
+          storeToCache(F, cacheKey, R);
+        }
+      }
+
+      {
+        PhaseTimer T(PHASE_OUTPUT);
+        errs() << "Load/Store Instructions:\n";
+        iinstrCount += R.omittableInstructions.size();
+        for (inst_iterator I = inst_begin(F), SrcE = inst_end(F); I != SrcE; ++I) {
+          if(isa<StoreInst>(&*I) || isa<LoadInst>(&*I)){
+            ++instrCount;
+            errs() << "\t" << (isa<StoreInst>(&*I) ? "Write " : "Read ") << getVarName(&*I) << " | ";
+            if(dl = I->getDebugLoc()) errs() << dl.getLine() << "," << dl.getCol();
+            else errs() << "INIT";
+            if(R.omittableInstructions.find(&*I) != R.omittableInstructions.end()){
+              CFG->getNode(&*I)->highlight();
+              DG->getNode(&*I)->highlight();
+              errs() << " | (OMIT) " << omissionLabel(R.omittableInstructions[&*I]);
+            }else if(R.loopInvariantInstructions.count(&*I)){
+              errs() << " | (LOOP-INV)";
+            }else if(R.rangeInstructions.count(&*I)){
+              errs() << " | (RANGE)";
+            }
+            errs() << "\n";
+          }
+        }
+
+        errs() << "Redundant Accesses:\n";
+        for(auto pair : R.redundantInstructions){
+          errs() << "\t" << pair.first->getDebugLoc().getLine() << "," << pair.first->getDebugLoc().getCol()
+                 << " -> " << pair.second->getDebugLoc().getLine() << "," << pair.second->getDebugLoc().getCol()
+                 << "|" << getVarName(pair.first) << "\n";
+        }
+
+        errs() << "Conditional Dependences:\n";
+        for(auto pair : R.conditionalDepMap){
+          errs() << pair.first->getName() << ":\n";
+          for(auto s: pair.second){
+            errs() << "\t" << s << "\n";
+          }
+        }
+
+        // The graphs are rendered from snapshots by the background writer, the
+        // output phase only takes the snapshots. Written bytes are counted in
+        // doFinalization
+        string fn = F.getName().str();
+        std::shared_ptr<const PDGSnapshot> cfgSnapshot = CFG->snapshot();
+        std::shared_ptr<const PDGSnapshot> depSnapshot = DG->snapshot();
+        errs() << "Printing CFG to " << fn + "_cfg.dot\n";
+        writer->submit(Stats.outputKey, PDG::outputPath(fn + "_cfg.dot"), [cfgSnapshot](raw_ostream &os){ cfgSnapshot->renderDot(os); });
+
+        errs() << "Printing DepGraph to " << fn + "_deps.dot\n";
+        writer->submit(Stats.outputKey, PDG::outputPath(fn + "_deps.dot"), [depSnapshot](raw_ostream &os){ depSnapshot->renderDot(os); });
+        errs() << "dumpInstructionInfo()\n";
+        writer->submit(Stats.outputKey, PDG::outputPath(fn + "_intructions.txt"), [depSnapshot](raw_ostream &os){ depSnapshot->renderInstructionInfo(os); });
+        if(dumpBinary){
+          writer->submit(Stats.outputKey, PDG::outputPath(fn + "_cfg.pdg"), [cfgSnapshot](raw_ostream &os){ cfgSnapshot->renderBinary(os); });
+          writer->submit(Stats.outputKey, PDG::outputPath(fn + "_deps.pdg"), [depSnapshot](raw_ostream &os){ depSnapshot->renderBinary(os); });
+        }
+        dumpLoopInvariantInfo(F, R.loopInvariantInstructions);
+        dumpRangeInfo(F, R.rangeInstructions);
+
+        vector<BasicBlock*> depBlocks = getConditionalDepBlocks(F, R.conditionalDepMap);
+        string counters;
+        if(instrumentBlockCounters && !depBlocks.empty())
+          counters = addBlockCounters(F, depBlocks);
+        dumpBlockDeps(F, R.conditionalDepMap, depBlocks, counters);
+      }
+
+      Stats.depEdges = DG->getEdges().size();
+      for(unsigned p = 0; p < NUM_PHASES; ++p)
+        Stats.phaseTimes[p] += getPhaseTime((DepAnalysisPhase)p);
+      cfgNodeCount += Stats.cfgNodes;
+      cfgEdgeCount += Stats.cfgEdges;
+      depEdgeCount += Stats.depEdges;
+      if(!depStatsJson.empty())
+        allStats.push_back(Stats);
+      moduleQueries += Stats.daQueries;
+      if(!depDumpResults.empty() || !depCheckGolden.empty())
+        collectResults(F, R);
+      if(!depExport.empty())
+        exportRuns.push_back(toDPDepRecords(DG->getDPDepMap()));
+
+      return instrumentBlockCounters;
+    }
+
+    bool doInitialization(Module &M) override {
+      writer.reset(new OutputWriter(depOutputQueue));
+      moduleCacheContext.clear();
+      blockCountersCtor = instrumentBlockCounters ? createBlockCountersCtor(M) : nullptr;
+      return instrumentBlockCounters;
+    }
+
+    bool doFinalization(Module &M) override {
+      writer->flush();
+      for(FunctionStats &S : allStats)
+        S.outputBytes = writer->getBytes(S.outputKey);
+      outputByteCount += writer->getTotalBytes();
+      writer.reset();
+
+      if(!depExport.empty())
+        exportDependences();
+      if(!depStatsJson.empty())
+        dumpStatsJson();
+
+      // Regression checks, a failure makes opt and the driver exit non-zero
+      std::sort(resultLines.begin(), resultLines.end());
+      bool failed = false;
+      if(!depDumpResults.empty())
+        dumpResults();
+      if(!depCheckGolden.empty())
+        failed |= !checkGolden();
+      double seconds = 0;
+      for(unsigned p = 0; p < NUM_PHASES; ++p)
+        if(p != PHASE_OUTPUT)
+          seconds += getPhaseTime((DepAnalysisPhase)p);
+      if(depPerfMaxSeconds > 0 && seconds > depPerfMaxSeconds){
+        errs() << "Analysis took " << seconds << "s, limit is " << depPerfMaxSeconds << "s\n";
+        failed = true;
+      }
+      if(depPerfMaxQueries && moduleQueries > depPerfMaxQueries){
+        errs() << "Analysis needed " << moduleQueries << " DA queries, limit is " << depPerfMaxQueries << "\n";
+        failed = true;
+      }
+      if(failed)
+        report_fatal_error("DepAnalysis regression check failed", false);
+      return false;
+    }
+
+    // One line per omission, summarized access, dependence edge, conditional
+    // dependence and DiscoPoP dependence, identified by debug location and
+    // variable name so they can be compared across runs and builds
+    void collectResults(Function &F, OmissionResult &R){
+      string fn = F.getName().str() + "|";
+      auto loc = [](Instruction *I){
+        DebugLoc dl = I->getDebugLoc();
+        return dl ? to_string(dl.getLine()) + ":" + to_string(dl.getCol()) : string("INIT");
+      };
+      auto access = [&](Instruction *I){
+        return loc(I) + "|" + (isa<StoreInst>(I) ? "w" : "r") + "|" + getVarName(I);
+      };
+      for(auto &pair : R.omittableInstructions)
+        resultLines.push_back(fn + "omit|" + access(pair.first) + "|" + omissionLabel(pair.second));
+      for(auto &pair : R.loopInvariantInstructions)
+        resultLines.push_back(fn + "loopinv|" + access(pair.first) + "|" + pair.second);
+      for(auto &pair : R.rangeInstructions)
+        resultLines.push_back(fn + "range|" + access(pair.first) + "|" + pair.second);
+      for(auto &pair : R.redundantInstructions)
+        resultLines.push_back(fn + "redundant|" + access(pair.first) + "|" + loc(pair.second));
+      for(auto edge : DG->getEdges())
+        resultLines.push_back(fn + "edge|" + access(edge.getSrc()->getItem()) + "|" + edgeLabel(edge) + "|" + access(edge.getDst()->getItem()));
+      for(auto &pair : R.conditionalDepMap)
+        for(auto &dep : pair.second)
+          resultLines.push_back(fn + "cond|" + pair.first->getName().str() + "|" + dep);
+      for(auto &pair : DG->getDPDepMap())
+        for(auto &dep : pair.second)
+          resultLines.push_back(fn + "dpdep|" + pair.first + "|" + dep);
+    }
+
+    // Merges the dependences of all functions and the -depExportMerge profile
+    // into one DiscoPoP dependence file, in a single k-way merge
+    void exportDependences(){
+      vector<std::unique_ptr<DPDepSource>> owned;
+      if(!depExportMerge.empty()){
+        vector<DPDepRecord> profile;
+        if(!readDPDepFile(depExportMerge, profile))
+          errs() << "Problem opening file: " << depExportMerge << "\n";
+        owned.emplace_back(new DPDepVectorSource(std::move(profile)));
+      }
+      for(auto &run : exportRuns)
+        owned.emplace_back(new DPDepVectorSource(std::move(run)));
+      exportRuns.clear();
+
+      vector<DPDepSource*> sources;
+      for(auto &source : owned)
+        sources.push_back(source.get());
+      uint64_t size, lines = 0;
+      string error;
+      if(OutputWriter::writeFile(depExport, [&](raw_ostream &os){ lines = mergeDPDeps(sources, os); }, size, error))
+        errs() << "Exported " << lines << " dependence lines to " << depExport << "\n";
+      else
+        errs() << error << "\n";
+    }
+
+    void dumpResults(){
+      ofstream stream;
+      stream.open(depDumpResults);
+      if (!stream.is_open())
+      {
+        errs() << "Problem opening file: " << depDumpResults << "\n";
+        return;
+      }
+      for(string &line : resultLines)
+        stream << line << "\n";
+      stream.close();
+    }
+
+    // Compares the results with the golden file, ignoring empty lines and
+    // '#' comments, and prints the differences diff-style
+    bool checkGolden(){
+      ifstream stream(depCheckGolden);
+      if (!stream.is_open())
+      {
+        errs() << "Problem opening golden file: " << depCheckGolden << "\n";
+        return false;
+      }
+      vector<string> golden;
+      string line;
+      while (getline(stream, line))
+      {
+        if (!line.empty() && line[0] != '#')
+          golden.push_back(line);
+      }
+      std::sort(golden.begin(), golden.end());
+
+      vector<string> missing, unexpected;
+      std::set_difference(golden.begin(), golden.end(), resultLines.begin(), resultLines.end(), back_inserter(missing));
+      std::set_difference(resultLines.begin(), resultLines.end(), golden.begin(), golden.end(), back_inserter(unexpected));
+      if(missing.empty() && unexpected.empty())
+        return true;
+      errs() << "Results differ from " << depCheckGolden << ":\n";
+      for(string &l : missing)
+        errs() << "-" << l << "\n";
+      for(string &l : unexpected)
+        errs() << "+" << l << "\n";
+      return false;
+    }
+
+    void dumpStatsJson(){
+      json::Array functions;
+      for(FunctionStats &S : allStats){
+        json::Object phases;
+        for(unsigned p = 0; p < NUM_PHASES; ++p)
+          phases[getPhaseName((DepAnalysisPhase)p)] = S.phaseTimes[p];
+        functions.push_back(json::Object{
+          {"name", S.name},
+          {"cached", S.cached},
+          {"budgetExceeded", S.budgetExceeded},
+          {"daQueries", S.daQueries},
+          {"cfgNodes", S.cfgNodes},
+          {"cfgEdges", S.cfgEdges},
+          {"depEdges", S.depEdges},
+          {"visitedNodes", S.visitedNodes},
+          {"outputBytes", (int64_t)S.outputBytes},
+          {"phaseTimes", std::move(phases)}
+        });
+      }
+      ofstream stream;
+      stream.open(depStatsJson);
+      if (!stream.is_open())
+      {
+        errs() << "Problem opening file: " << depStatsJson << "\n";
+        return;
+      }
+      string buffer;
+      raw_string_ostream os(buffer);
+      os << json::Value(json::Object{{"functions", std::move(functions)}});
+      stream << os.str() << "\n";
+      stream.close();
+    }
+
+    // Whether the function exceeded one of the -depBudget* limits; sets
+    // Stats.budgetExceeded
+    bool overBudget(){
+      if(!Stats.budgetExceeded.empty())
+        return true;
+      if(depBudgetQueries && Stats.daQueries > depBudgetQueries)
+        Stats.budgetExceeded = "DA queries";
+      else if(depBudgetNodes && Stats.visitedNodes > depBudgetNodes)
+        Stats.budgetExceeded = "visited nodes";
+      else if(depBudgetSeconds > 0 && std::chrono::duration<double>(std::chrono::steady_clock::now() - analysisStart).count() > depBudgetSeconds)
+        Stats.budgetExceeded = "wall time";
+      return !Stats.budgetExceeded.empty();
+    }
+
+    // Conservative result: everything with a debug location is instrumented
+    void dropOmissions(OmissionResult &R){
+      map<Instruction*, OmissionReason> nodbg;
+      for(auto &pair : R.omittableInstructions)
+        if(pair.second == OmissionReason::NODBG)
+          nodbg.insert(pair);
+      R = OmissionResult();
+      R.omittableInstructions = nodbg;
+    }
+
+    // DependenceInfo::depends, counted for -stats
+    std::unique_ptr<Dependence> depends(Instruction *Src, Instruction *Dst){
+      ++daQueryCount;
+      ++Stats.daQueries;
+      return DI->depends(Src, Dst, true);
+    }
+
+    // Create Store/Load-CFG
+    void buildCFG(Function &F){
+      DebugLoc dl;
+      std::function<void(BasicBlock*,Instruction*)> add_first_successor_store_load_instructions;
+      add_first_successor_store_load_instructions = [&](BasicBlock *BB, Instruction* previousInstruction)
+      {
+        bool hasSuccessors = false;
+        for (BasicBlock *S : successors(BB)) {
+          hasSuccessors = true;
+          for (Instruction &I : *S){
+            DebugLoc dl = I.getDebugLoc();
+            if(!dl) continue;
+            if(isa<StoreInst>(I) || isa<LoadInst>(I)){
+              CFG->addEdge(previousInstruction, &I, EdgeDepType::CTR);
+              goto next;
+            }else if(isa<DbgDeclareInst>(&I)){
+              CFG->addEdge(previousInstruction, &I, EdgeDepType::CTR);
+              goto next;
+            }
+          }
+          if(S != BB) 
+            add_first_successor_store_load_instructions(S, previousInstruction);
+          next:;
+        }
+        if(BB->getName().find("for.end") != string::npos && !hasSuccessors){
+          CFG->connectToExit(previousInstruction);
+        }
+      };
+      Instruction *previousInstruction;
+      for (BasicBlock &BB : F){
+        // Add current block's store/load-instructions and declarations to graph
+        previousInstruction = nullptr;
+        for (Instruction &I : BB){
+          dl = I.getDebugLoc();
+          if(!dl) continue;
+          DbgDeclareInst* DbgDeclare = dyn_cast<DbgDeclareInst>(&I);
+          if(isa<StoreInst>(I) || isa<LoadInst>(I) || DbgDeclare){
+            if(previousInstruction != nullptr){
+                CFG->addEdge(previousInstruction, &I, EdgeDepType::CTR);
+            }
+            previousInstruction = &I;
+          }
+        }
+        // Add edges from last instruction in current block to first instruction all the successor blocks
+        if(previousInstruction != nullptr){
+          add_first_successor_store_load_instructions(&BB, previousInstruction);
+        }
+      }
+      // Conect exit nodes
+      for(auto node : CFG->getNodes()){
+        if(!CFG->isVirtual(node)){
+          if(CFG->getInEdges(node).empty()){
+            CFG->connectToEntry(node->getItem());
+          }else if(CFG->getOutEdges(node).empty()){
+            CFG->connectToExit(node->getItem());
+          }
+        }
+      }
+    }
+
+    // Local variables that are never written and loads of read-only globals
+    void findLocalOmissions(Function &F, OmissionResult &R, set<Value*> &localValues){
+      DebugLoc dl;
+      set<Value*> writtenValues;
       Value *v;
       // Get local and written values (variables)
       for (inst_iterator I = inst_begin(F), SrcE = inst_end(F); I != SrcE; ++I) {
@@ -114,113 +682,69 @@ namespace {
           }
         }
       }
-      // Remove values passed outside by reference from localValues
+      // Remove values passed outside by reference from localValues. Passing a
+      // value to a call only lets it escape if the callee may capture it; a
+      // callee that may write through a non-captured argument writes the value.
+      // Callees defined in the module are judged by their FunctionSummary.
       for (inst_iterator I = inst_begin(F), SrcE = inst_end(F); I != SrcE; ++I) {
-        if(CallInst* call_inst = dyn_cast<CallInst>(&*I)){
-          for(uint i = 0; i < call_inst->getNumOperands() - 1; ++i){
-            v = call_inst->getArgOperand(i);
-            localValues.erase(v);
+        if(CallBase* call_inst = dyn_cast<CallBase>(&*I)){
+          if(isa<DbgInfoIntrinsic>(call_inst)) continue;
+          for(uint i = 0; i < call_inst->arg_size(); ++i){
+            v = FunctionSummaryPass::getBaseObject(call_inst->getArgOperand(i));
+            if(localValues.find(v) == localValues.end()) continue;
+            if(!v->getType()->isPointerTy() || FS->callMayCaptureArg(call_inst, i)){
+              localValues.erase(v);
+            }else if(FS->callMayWriteArg(call_inst, i)){
+              writtenValues.insert(v);
+            }
           }
         }
         if(ReturnInst* ret_inst = dyn_cast<ReturnInst>(&*I)){
           localValues.erase(ret_inst->getReturnValue());
         }
       }
+      // Addresses may also escape by being stored, returned as derived pointers, ...
+      for(auto it = localValues.begin(); it != localValues.end();){
+        if((*it)->getType()->isPointerTy() && mayEscape(*it))
+          it = localValues.erase(it);
+        else
+          ++it;
+      }
 
       for (inst_iterator I = inst_begin(F), SrcE = inst_end(F); I != SrcE; ++I) {
         if(isa<StoreInst>(&*I) || isa<LoadInst>(&*I)){
           dl = I->getDebugLoc();
           v = I->getOperand(isa<StoreInst>(&*I) ? 1 : 0);
-          if(
-            !dl // this can be removed as DiscoPoP doesn't instrument them anyways
-            || (
-              localValues.find(v) != localValues.end()
-              && writtenValues.find(v) == writtenValues.end()
-            ) 
+          if(!dl){ // this can be removed as DiscoPoP doesn't instrument them anyways
+            R.omittableInstructions[&*I] = OmissionReason::NODBG;
+          }else if(
+            localValues.find(v) != localValues.end()
+            && writtenValues.find(v) == writtenValues.end()
             //|| v->getName() == "retval"
-          ) omittableInstructions.insert(&*I);
-        }
-      }
-      
-
-
-      errs() << "\tBuilding DepGraph\n";
-      DI = &getAnalysis<DependenceAnalysisWrapperPass>().getDI();
-      DominatorTree& DT = getAnalysis<DominatorTreeWrapperPass>().getDomTree();
-      PostDominatorTree& PDT = getAnalysis<PostDominatorTreeWrapperPass>().getPostDomTree();
-      DG = new PDG(F.getName(), &F);
-      CFG = new PDG(F.getName(), &F);
-
-      // Create Store/Load-CFG
-      {
-        std::function<void(BasicBlock*,Instruction*)> add_first_successor_store_load_instructions;
-        add_first_successor_store_load_instructions = [&](BasicBlock *BB, Instruction* previousInstruction)
-        {
-          bool hasSuccessors = false;
-          for (BasicBlock *S : successors(BB)) {
-            hasSuccessors = true;
-            for (Instruction &I : *S){
-              DebugLoc dl = I.getDebugLoc();
-              if(!dl) continue;
-              if(isa<StoreInst>(I) || isa<LoadInst>(I)){
-                CFG->addEdge(previousInstruction, &I, EdgeDepType::CTR);
-                goto next;
-              }else if(isa<DbgDeclareInst>(&I)){
-                CFG->addEdge(previousInstruction, &I, EdgeDepType::CTR);
-                goto next;
-              }
-            }
-            if(S != BB) 
-              add_first_successor_store_load_instructions(S, previousInstruction);
-            next:;
-          }
-          if(BB->getName().find("for.end") != string::npos && !hasSuccessors){
-            CFG->connectToExit(previousInstruction);
-          }
-        };
-        Instruction *previousInstruction;
-        for (BasicBlock &BB : F){
-          // Add current block's store/load-instructions and declarations to graph
-          previousInstruction = nullptr;
-          for (Instruction &I : BB){
-            dl = I.getDebugLoc();
-            if(!dl) continue;
-            DbgDeclareInst* DbgDeclare = dyn_cast<DbgDeclareInst>(&I);
-            if(isa<StoreInst>(I) || isa<LoadInst>(I) || DbgDeclare){
-              if(previousInstruction != nullptr){
-                  CFG->addEdge(previousInstruction, &I, EdgeDepType::CTR);
-              }
-              previousInstruction = &I;
-            }
-          }
-          // Add edges from last instruction in current block to first instruction all the successor blocks
-          if(previousInstruction != nullptr){
-            add_first_successor_store_load_instructions(&BB, previousInstruction);
-          }
-        }
-        // Conect exit nodes
-        for(auto node : CFG->getNodes()){
-          if(node != CFG->getEntry() && node != CFG->getExit()){
-            if(CFG->getInEdges(node).empty()){
-              CFG->connectToEntry(node->getItem());
-            }else if(CFG->getOutEdges(node).empty()){
-              CFG->connectToExit(node->getItem());
-            }
+          ) R.omittableInstructions[&*I] = OmissionReason::LOCAL;
+          else if(GlobalVariable *GV = dyn_cast<GlobalVariable>(FunctionSummaryPass::getBaseObject(v))){
+            if(FS->isReadOnly(GV))
+              R.omittableInstructions[&*I] = OmissionReason::READONLY;
           }
         }
       }
+    }
 
-      recursiveDepFinder();
+    // Accesses to local variables whose dependences all hold whenever their block
+    // executes (the other end dominates) are omitted and the dependences recorded
+    void findConditionalOmissions(Function &F, OmissionResult &R, set<Value*> &localValues){
+      DominatorTree& DT = getAnalysis<DominatorTreeWrapperPass>().getDomTree();
       Instruction *I, *J;
+      Value *v;
+      DenseSet<pair<Instruction*, Instruction*>> undominated = findUndominatedDeps(DT);
       
-      map<BasicBlock*, set<string>> conditionalDepMap;
       for(auto node : DG->getNodes()){
         if(node != DG->getEntry() && node != DG->getExit()){
           I = node->getItem();
           set<string> tmpDeps;
           for(auto edge: DG->getOutEdges(node)){
-            J = edge->getDst()->getItem();
-            if(I == J || !DT.dominates(J, I)){
+            J = edge.getDst()->getItem();
+            if(I == J || undominated.count(make_pair(I, J))){
               errs () << "Can't omit " << CFG->getNodeIndex(I) << ": !dominates("
                       << CFG->getNodeIndex(J) << ", " << CFG->getNodeIndex(I) << ")\n";
               goto next;
@@ -234,8 +758,8 @@ namespace {
             );
           }
           for(auto edge: DG->getInEdges(node)){
-            J = edge->getSrc()->getItem();
-            if(I == J || !DT.dominates(I, J)) {
+            J = edge.getSrc()->getItem();
+            if(I == J || undominated.count(make_pair(J, I))) {
               errs () << "Can't omit " << CFG->getNodeIndex(I) << ": !dominates("
                       << CFG->getNodeIndex(I) << ", " << CFG->getNodeIndex(J) << ")\n";
               goto next;
@@ -250,78 +774,624 @@ namespace {
           }
           v = I->getOperand(isa<StoreInst>(&*I) ? 1 : 0);
           if(localValues.find(v) != localValues.end()){
-            omittableInstructions.insert(I);
-            if(!conditionalDepMap.count(I->getParent()))
-              conditionalDepMap[I->getParent()] = tmpDeps;
+            R.omittableInstructions.insert(make_pair(I, OmissionReason::CONDITIONAL));
+            if(!R.conditionalDepMap.count(I->getParent()))
+              R.conditionalDepMap[I->getParent()] = tmpDeps;
             else
-              conditionalDepMap[I->getParent()].insert(tmpDeps.begin(), tmpDeps.end());
+              R.conditionalDepMap[I->getParent()].insert(tmpDeps.begin(), tmpDeps.end());
           }
           next:;
         }
       }
-      
-      errs() << "Load/Store Instructions:\n";
-      iinstrCount += omittableInstructions.size();
+    }
+
+    // Both checks of an edge (src, dst) in findConditionalOmissions are whether
+    // dst dominates src. One walk over the dominator tree answers them for all
+    // edges: the active accesses are the ones before the current instruction in
+    // its block and its dominators. Edges from unreachable blocks are not visited
+    // and count as dominated, as with DT.dominates
+    DenseSet<pair<Instruction*, Instruction*>> findUndominatedDeps(DominatorTree &DT){
+      DenseSet<pair<Instruction*, Instruction*>> undominated;
+      DenseSet<Instruction*> accesses, active;
+      for(auto node : DG->getNodes())
+        if(!DG->isVirtual(node))
+          accesses.insert(node->getItem());
+
+      std::function<void(DomTreeNode*)> visit;
+      visit = [&](DomTreeNode *N)
+      {
+        vector<Instruction*> scope;
+        for (Instruction &I : *N->getBlock()){
+          if(!accesses.count(&I))
+            continue;
+          for(auto edge : DG->getOutEdges(DG->getNode(&I))){
+            Instruction *J = edge.getDst()->getItem();
+            if(!active.count(J))
+              undominated.insert(make_pair(&I, J));
+          }
+          active.insert(&I);
+          scope.push_back(&I);
+        }
+
+        for(DomTreeNode *child : *N)
+          visit(child);
+        for(Instruction *I : scope)
+          active.erase(I);
+      };
+      visit(DT.getRootNode());
+      return undominated;
+    }
+
+    // A load is loop-invariant if its address is invariant in the enclosing loop
+    // and nothing in the loop may modify the loaded location. Every iteration then
+    // observes the same dependences, so the access can be instrumented once per
+    // loop entry together with the iteration count. The outermost such loop is used.
+    void findLoopInvariantAccesses(Function &F, OmissionResult &R){
+      LoopInfo &LI = getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+      ScalarEvolution &SE = getAnalysis<ScalarEvolutionWrapperPass>().getSE();
+      DominatorTree &DT = getAnalysis<DominatorTreeWrapperPass>().getDomTree();
+      AliasAnalysis &AA = getAnalysis<AAResultsWrapperPass>().getAAResults();
+
       for (inst_iterator I = inst_begin(F), SrcE = inst_end(F); I != SrcE; ++I) {
-        if(isa<StoreInst>(&*I) || isa<LoadInst>(&*I)){
-          ++instrCount;
-          errs() << "\t" << (isa<StoreInst>(&*I) ? "Write " : "Read ") << getVarName(&*I) << " | ";
-          if(dl = I->getDebugLoc()) errs() << dl.getLine() << "," << dl.getCol();
-          else errs() << "INIT";
-          if(omittableInstructions.find(&*I) != omittableInstructions.end()){
-            CFG->getNode(&*I)->highlight();
-            DG->getNode(&*I)->highlight();
-            errs() << " | (OMIT)";
+        LoadInst *load = dyn_cast<LoadInst>(&*I);
+        if(!load || !load->getDebugLoc() || R.omittableInstructions.count(load))
+          continue;
+        Value *ptr = load->getPointerOperand();
+        if(!SE.isSCEVable(ptr->getType()))
+          continue;
+        const SCEV *ptrSCEV = SE.getSCEV(ptr);
+
+        Loop *hoistLoop = nullptr;
+        for(Loop *L = LI.getLoopFor(load->getParent()); L != nullptr; L = L->getParentLoop()){
+          if(!SE.isLoopInvariant(ptrSCEV, L) || isModifiedInLoop(L, load, AA))
+            break;
+          hoistLoop = L;
+        }
+        if(hoistLoop == nullptr)
+          continue;
+
+        DebugLoc headerDL = hoistLoop->getStartLoc();
+        R.loopInvariantInstructions[load] =
+          (headerDL ? to_string(headerDL.getLine()) : "?")
+          + "|" + getTripCount(hoistLoop, load->getParent(), SE, DT);
+      }
+    }
+
+    // A GEP-based access whose address is an affine AddRec {base,+,stride} of its
+    // innermost loop touches a strided range of memory. If the access executes on
+    // every iteration and DA can decide its dependences with all other accesses in
+    // the loop, the whole stream is summarized by (base, stride, trip count).
+    void findAffineRangeAccesses(Function &F, OmissionResult &R){
+      LoopInfo &LI = getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+      ScalarEvolution &SE = getAnalysis<ScalarEvolutionWrapperPass>().getSE();
+      DominatorTree &DT = getAnalysis<DominatorTreeWrapperPass>().getDomTree();
+      DI = &getAnalysis<DependenceAnalysisWrapperPass>().getDI();
+
+      for (inst_iterator I = inst_begin(F), SrcE = inst_end(F); I != SrcE; ++I) {
+        if(!(isa<StoreInst>(&*I) || isa<LoadInst>(&*I)) || !I->getDebugLoc())
+          continue;
+        if(R.omittableInstructions.count(&*I) || R.loopInvariantInstructions.count(&*I))
+          continue;
+        Value *ptr = I->getOperand(isa<StoreInst>(&*I) ? 1 : 0);
+        if(!isa<GetElementPtrInst>(ptr))
+          continue;
+        Loop *L = LI.getLoopFor(I->getParent());
+        const SCEVAddRecExpr *AR = dyn_cast<SCEVAddRecExpr>(SE.getSCEV(ptr));
+        if(L == nullptr || AR == nullptr || AR->getLoop() != L || !AR->isAffine())
+          continue;
+        const SCEVConstant *stride = dyn_cast<SCEVConstant>(AR->getStepRecurrence(SE));
+        BasicBlock *latch = L->getLoopLatch();
+        if(stride == nullptr || latch == nullptr || !DT.dominates(I->getParent(), latch))
+          continue;
+        string tripCount = getTripCount(L, I->getParent(), SE, DT);
+        if(tripCount == "?" || !hasDecidableDependences(&*I, L))
+          continue;
+
+        string r;
+        raw_string_ostream rso(r);
+        rso << *AR->getStart() << "|" << stride->getAPInt().getSExtValue() << "|" << tripCount;
+        R.rangeInstructions[&*I] = rso.str();
+      }
+    }
+
+    // Available-access analysis scoped by the dominator tree: a read of an address
+    // that was already read earlier on every path, with no intervening instruction
+    // that may modify it, observes the same dependences as that earlier read.
+    // Blocks with more than one predecessor start with nothing available.
+    // Redundant reads are mapped to the earlier (leading) read. Writes never lead,
+    // the profiler has to see the RAW dependence of the read after them.
+    void findRedundantAccesses(Function &F, OmissionResult &R){
+      DominatorTree &DT = getAnalysis<DominatorTreeWrapperPass>().getDomTree();
+      AliasAnalysis &AA = getAnalysis<AAResultsWrapperPass>().getAAResults();
+
+      auto isInstrumented = [&](Instruction *I){
+        return I->getDebugLoc()
+          && !R.omittableInstructions.count(I)
+          && !R.loopInvariantInstructions.count(I)
+          && !R.rangeInstructions.count(I);
+      };
+
+      std::function<void(DomTreeNode*, map<Value*, Instruction*>)> visit;
+      visit = [&](DomTreeNode *N, map<Value*, Instruction*> available)
+      {
+        BasicBlock *BB = N->getBlock();
+        if(N->getIDom() == nullptr || BB->getSinglePredecessor() != N->getIDom()->getBlock())
+          available.clear();
+
+        for (Instruction &I : *BB){
+          if(LoadInst *load = dyn_cast<LoadInst>(&I)){
+            if(!isInstrumented(load))
+              continue;
+            auto leader = available.find(load->getPointerOperand());
+            if(leader != available.end()){
+              R.omittableInstructions[load] = OmissionReason::REDUNDANT;
+              R.redundantInstructions[load] = leader->second;
+            }else{
+              available[load->getPointerOperand()] = load;
+            }
+          }else if(I.mayWriteToMemory()){
+            for(auto it = available.begin(); it != available.end();){
+              if(mayModify(&I, it->second, AA))
+                it = available.erase(it);
+              else
+                ++it;
+            }
           }
-          errs() << "\n";
         }
+
+        for(DomTreeNode *child : *N)
+          visit(child, available);
+      };
+      visit(DT.getRootNode(), map<Value*, Instruction*>());
+    }
+
+    // Calls are additionally checked against the callee's FunctionSummary
+    bool mayModify(Instruction *I, Instruction *access, AliasAnalysis &AA){
+      if(!isModSet(AA.getModRefInfo(I, getAccessLocation(access))))
+        return false;
+      CallBase *call = dyn_cast<CallBase>(I);
+      if(call == nullptr)
+        return true;
+      Value *base = FunctionSummaryPass::getBaseObject(access->getOperand(isa<StoreInst>(access) ? 1 : 0));
+      return FS->callMayWriteObject(call, base, !isa<AllocaInst>(base) || mayEscape(base));
+    }
+
+    bool mayEscape(Value *v){
+      SummaryCaptureTracker tracker(FS);
+      PointerMayBeCaptured(v, &tracker);
+      return tracker.Captured;
+    }
+
+    MemoryLocation getAccessLocation(Instruction *I){
+      if(StoreInst *store = dyn_cast<StoreInst>(I))
+        return MemoryLocation::get(store);
+      return MemoryLocation::get(cast<LoadInst>(I));
+    }
+
+    // Whether a dependence may be carried by a loop: one of its levels has a
+    // < or > direction, or DA gave up on accesses that share a loop
+    bool isLoopCarried(Dependence &D, Instruction *Src, Instruction *Dst){
+      if(D.isConfused()){
+        LoopInfo &LI = getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+        Loop *L = LI.getLoopFor(Src->getParent());
+        while(L && !L->contains(Dst))
+          L = L->getParentLoop();
+        return L != nullptr;
       }
+      for(unsigned level = 1; level <= D.getLevels(); ++level){
+        if(D.getDirection(level) & (Dependence::DVEntry::LT | Dependence::DVEntry::GT))
+          return true;
+      }
+      return false;
+    }
 
-      errs() << "Conditional Dependences:\n";
-      for(auto pair : conditionalDepMap){
-        errs() << pair.first->getName() << ":\n";
-        for(auto s: pair.second){
-          errs() << "\t" << s << "\n";
+    // Accesses of a local variable are omitted if none of its dependences is
+    // loop-carried. DA is queried for all pairs of accesses of the variable,
+    // since the dependence search stops at the first dependence on a path and
+    // may not see carried ones. Variables that calls can access are skipped.
+    void findLoopIndependentOmissions(Function &F, OmissionResult &R, set<Value*> &localValues){
+      map<Value*, vector<Instruction*>> accesses;
+      set<Value*> passedToCalls;
+      for (inst_iterator I = inst_begin(F), SrcE = inst_end(F); I != SrcE; ++I) {
+        if(CallBase *call = dyn_cast<CallBase>(&*I)){
+          if(isa<DbgInfoIntrinsic>(call)) continue;
+          for(uint i = 0; i < call->arg_size(); ++i)
+            passedToCalls.insert(FunctionSummaryPass::getBaseObject(call->getArgOperand(i)));
+        }else if(isa<StoreInst>(&*I) || isa<LoadInst>(&*I)){
+          Value *base = FunctionSummaryPass::getBaseObject(I->getOperand(isa<StoreInst>(&*I) ? 1 : 0));
+          accesses[base].push_back(&*I);
+        }else if(isa<AtomicRMWInst>(&*I) || isa<AtomicCmpXchgInst>(&*I)){
+          // Not checked by DA, treated like an unknown call
+          passedToCalls.insert(FunctionSummaryPass::getBaseObject(I->getOperand(0)));
         }
       }
 
-      errs() << "Printing CFG to " << F.getName().str() + "_cfg.dot\n";
-      CFG->dumpToDot(F.getName().str() + "_cfg.dot");
+      for(auto &pair : accesses){
+        if(!isa<AllocaInst>(pair.first) || !localValues.count(pair.first) || passedToCalls.count(pair.first))
+          continue;
+        bool carried = false;
+        for(Instruction *A : pair.second){
+          for(Instruction *B : pair.second){
+            if(carried || overBudget()) break;
+            if(isa<LoadInst>(A) && isa<LoadInst>(B)) continue;
+            if(auto D = depends(A, B))
+              carried = isLoopCarried(*D, A, B);
+          }
+        }
+        if(carried || overBudget()) continue;
+        for(Instruction *A : pair.second){
+          if(!A->getDebugLoc() || R.omittableInstructions.count(A)
+             || R.loopInvariantInstructions.count(A) || R.rangeInstructions.count(A))
+            continue;
+          R.omittableInstructions[A] = OmissionReason::LOOPINDEP;
+        }
+      }
+    }
 
-      errs() << "Printing DepGraph to " << F.getName().str() + "_deps.dot\n";
-      DG->dumpToDot(F.getName().str() + "_deps.dot");
-      DG->dumpInstructionInfo();
+    bool hasDecidableDependences(Instruction *I, Loop *L){
+      for(BasicBlock *BB : L->blocks()){
+        for(Instruction &J : *BB){
+          if(!isa<StoreInst>(J) && !isa<LoadInst>(J)){
+            // Calls, atomics, ... can not be checked by DA
+            if(!isa<DbgInfoIntrinsic>(J) && J.mayReadOrWriteMemory())
+              return false;
+            continue;
+          }
+          if(isa<LoadInst>(I) && isa<LoadInst>(J))
+            continue;
+          if(auto D = depends(I, &J)){
+            if(D->isConfused())
+              return false;
+          }
+        }
+      }
+      return true;
+    }
 
+    bool isModifiedInLoop(Loop *L, Instruction *access, AliasAnalysis &AA){
+      for(BasicBlock *BB : L->blocks()){
+        for(Instruction &I : *BB){
+          if(I.mayWriteToMemory() && mayModify(&I, access, AA))
+            return true;
+        }
+      }
       return false;
     }
 
+    // Number of times BB, a block of L, executes per loop entry if it runs on
+    // every iteration: constant if known, symbolic otherwise. "?" means it has
+    // to be counted at runtime, also for loops without a single latch or
+    // exiting block.
+    string getTripCount(Loop *L, BasicBlock *BB, ScalarEvolution &SE, DominatorTree &DT){
+      const SCEV *tripCount = SE.getBackedgeTakenCount(L);
+      BasicBlock *latch = L->getLoopLatch();
+      BasicBlock *exiting = L->getExitingBlock();
+      if(isa<SCEVCouldNotCompute>(tripCount) || latch == nullptr || exiting == nullptr)
+        return "?";
+      // Blocks up to the exiting block also run in the iteration that leaves the
+      // loop, once more than the backedge is taken: the whole body of a rotated
+      // loop, only the header of a -O0 for.cond loop
+      bool runsOnExit = DT.dominates(BB, exiting);
+      if(const SCEVConstant *c = dyn_cast<SCEVConstant>(tripCount)){
+        APInt count = c->getAPInt();
+        if(runsOnExit){
+          if(count.isMaxValue())  // would wrap to 0
+            return "?";
+          ++count;
+        }
+        SmallString<20> r;
+        count.toStringUnsigned(r);
+        return r.str().str();
+      }
+      if(runsOnExit)
+        tripCount = SE.getAddExpr(tripCount, SE.getOne(tripCount->getType()));
+      string r;
+      raw_string_ostream rso(r);
+      rso << *tripCount;
+      return rso.str();
+    }
+
+    // The reports need the IR, so they are rendered here and only written by
+    // the background writer
+    void dumpLoopInvariantInfo(Function &F, map<Instruction*, string> &loopInvariantInstructions){
+      string buffer;
+      raw_string_ostream stream(buffer);
+      // r|var|line|col|loopLine|tripCount
+      for (inst_iterator I = inst_begin(F), SrcE = inst_end(F); I != SrcE; ++I) {
+        if(loopInvariantInstructions.count(&*I)){
+          DebugLoc dl = I->getDebugLoc();
+          stream
+            << "r"
+            << "|" << getVarName(&*I)
+            << "|" << dl.getLine()
+            << "|" << dl.getCol()
+            << "|" << loopInvariantInstructions[&*I]
+            << "\n"
+          ;
+        }
+      }
+      submitReport(PDG::outputPath(F.getName().str() + "_loopinvariant.txt"), stream.str());
+    }
+
+    void dumpRangeInfo(Function &F, map<Instruction*, string> &rangeInstructions){
+      string buffer;
+      raw_string_ostream stream(buffer);
+      // r/w|var|line|col|base|stride|tripCount
+      for (inst_iterator I = inst_begin(F), SrcE = inst_end(F); I != SrcE; ++I) {
+        if(rangeInstructions.count(&*I)){
+          DebugLoc dl = I->getDebugLoc();
+          stream
+            << (isa<StoreInst>(&*I) ? "w" : "r")
+            << "|" << getVarName(&*I)
+            << "|" << dl.getLine()
+            << "|" << dl.getCol()
+            << "|" << rangeInstructions[&*I]
+            << "\n"
+          ;
+        }
+      }
+      submitReport(PDG::outputPath(F.getName().str() + "_ranges.txt"), stream.str());
+    }
+
+    // Blocks with conditional dependences in function order; their position is
+    // their id in <function>_blockdeps.txt and the counter array
+    vector<BasicBlock*> getConditionalDepBlocks(Function &F, map<BasicBlock*, set<string>> &conditionalDepMap){
+      vector<BasicBlock*> blocks;
+      for(BasicBlock &BB : F)
+        if(conditionalDepMap.count(&BB))
+          blocks.push_back(&BB);
+      return blocks;
+    }
+
+    // Adds an i64 counter array with one counter per block and increments
+    // the counter at every block entry. The increments have no debug
+    // location, so DiscoPoP does not instrument them. Returns the array name.
+    // The array is internal, so every module can have its own; the copies of
+    // an ODR function share one array, kept or dropped together with the
+    // function's comdat.
+    string addBlockCounters(Function &F, vector<BasicBlock*> &blocks){
+      LLVMContext &C = F.getContext();
+      Type *counterType = Type::getInt64Ty(C);
+      ArrayType *arrayType = ArrayType::get(counterType, blocks.size());
+      bool odr = F.hasLinkOnceODRLinkage() || F.hasWeakODRLinkage();
+      GlobalVariable *counters = new GlobalVariable(*F.getParent(), arrayType, false,
+                                                    odr ? GlobalValue::LinkOnceODRLinkage : GlobalValue::InternalLinkage,
+                                                    ConstantAggregateZero::get(arrayType), "__dep_block_counters_" + F.getName());
+      if(F.hasComdat())
+        counters->setComdat(F.getComdat());
+      for(unsigned i = 0; i < blocks.size(); ++i){
+        BasicBlock::iterator insertPt = blocks[i]->getFirstInsertionPt();
+        if(insertPt == blocks[i]->end())
+          continue;
+        IRBuilder<> B(&*insertPt);
+        B.SetCurrentDebugLocation(DebugLoc());
+        Constant *indices[] = {B.getInt64(0), B.getInt64(i)};
+        Constant *counter = ConstantExpr::getInBoundsGetElementPtr(arrayType, counters, indices);
+        Value *count = B.CreateLoad(counterType, counter);
+        B.CreateStore(B.CreateAdd(count, B.getInt64(1)), counter);
+      }
+      registerBlockCounters(counters);
+      return counters->getName().str();
+    }
+
+    // A constructor hands every counter array to the profiler runtime before
+    // main:
+    //   void __dep_register_block_counters(const char *name, uint64_t *counters, uint64_t n)
+    // The name is the one in <function>_blockdeps.txt. The copies of an ODR
+    // function's array are merged by the linker, so the runtime may see the
+    // same array once per module that contained the function.
+    // The constructor is created up front, since doFinalization runs after
+    // the module was printed or written; addBlockCounters adds the calls.
+    Function *createBlockCountersCtor(Module &M){
+      LLVMContext &C = M.getContext();
+      Function *ctor = Function::Create(FunctionType::get(Type::getVoidTy(C), false), GlobalValue::InternalLinkage,
+                                        "__dep_register_block_counters_ctor", &M);
+      ReturnInst::Create(C, BasicBlock::Create(C, "entry", ctor));
+      appendToGlobalCtors(M, ctor, 0);
+      return ctor;
+    }
+
+    void registerBlockCounters(GlobalVariable *counters){
+      Module &M = *counters->getParent();
+      LLVMContext &C = M.getContext();
+      Function *registerFn = M.getFunction("__dep_register_block_counters");
+      if(registerFn == nullptr){
+        FunctionType *registerType = FunctionType::get(Type::getVoidTy(C),
+            {Type::getInt8PtrTy(C), Type::getInt64PtrTy(C), Type::getInt64Ty(C)}, false);
+        registerFn = Function::Create(registerType, GlobalValue::ExternalLinkage, "__dep_register_block_counters", &M);
+      }
+
+      IRBuilder<> B(blockCountersCtor->getEntryBlock().getTerminator());
+      ArrayType *arrayType = cast<ArrayType>(counters->getValueType());
+      Constant *indices[] = {B.getInt64(0), B.getInt64(0)};
+      Value *args[] = {
+        B.CreateGlobalStringPtr(counters->getName()),
+        ConstantExpr::getInBoundsGetElementPtr(arrayType, counters, indices),
+        B.getInt64(arrayType->getNumElements())
+      };
+      B.CreateCall(registerFn, args);
+    }
+
+    // The static dependences that hold whenever a block executes, so the
+    // profiler can add them per block entry instead of per access:
+    //   counters|<counter array and registration name, empty if not instrumented>|<blocks>
+    //   <id>|<block>|<line> NOM  <type> <line>|<var>
+    void dumpBlockDeps(Function &F, map<BasicBlock*, set<string>> &conditionalDepMap, vector<BasicBlock*> &blocks, string counters){
+      string buffer;
+      raw_string_ostream stream(buffer);
+      stream << "counters|" << counters << "|" << blocks.size() << "\n";
+      for(unsigned i = 0; i < blocks.size(); ++i){
+        string name = blocks[i]->getName().str();
+        if(name.empty())
+          name = "bb" + to_string(std::distance(F.begin(), blocks[i]->getIterator()));
+        for(const string &dep : conditionalDepMap[blocks[i]])
+          stream << i << "|" << name << "|" << dep << "\n";
+      }
+      submitReport(PDG::outputPath(F.getName().str() + "_blockdeps.txt"), stream.str());
+    }
+
+    void submitReport(string path, string content){
+      writer->submit(Stats.outputKey, path, [content](raw_ostream &os){ os << content; });
+    }
+
+    // The key covers the function's IR and debug locations and everything outside
+    // of the function the results depend on: the module's target and read-only
+    // globals and the complete summaries, or the attributes, of the callees.
+    string getCacheContext(Function &F){
+      if(moduleCacheContext.empty()){
+        raw_string_ostream mso(moduleCacheContext);
+        Module *M = F.getParent();
+        mso << "omitLoopIndependent " << omitLoopIndependent << "\n"
+            << "datalayout " << M->getDataLayoutStr() << "\n"
+            << "triple " << M->getTargetTriple() << "\n";
+        printGlobalNames(mso, "readonly", FS->getReadOnlyGlobals());
+        mso.flush();
+      }
+
+      string r;
+      raw_string_ostream rso(r);
+      rso << moduleCacheContext;
+      for (inst_iterator I = inst_begin(F), SrcE = inst_end(F); I != SrcE; ++I) {
+        CallBase *call = dyn_cast<CallBase>(&*I);
+        if(call == nullptr || isa<DbgInfoIntrinsic>(call))
+          continue;
+        Function *callee = call->getCalledFunction();
+        rso << "call " << (callee ? callee->getName() : StringRef("<indirect>")) << "\n";
+        const FunctionSummary *summary = FS->getSummary(callee);
+        if(summary == nullptr){
+          // Judged by the attributes of the call site and the declaration
+          printAttributes(rso, call->getAttributes(), call->arg_size());
+          if(callee)
+            printAttributes(rso, callee->getAttributes(), callee->arg_size());
+          continue;
+        }
+        rso << "  args ";
+        for(unsigned i = 0; i < summary->argRead.size(); ++i)
+          rso << summary->argRead[i] << summary->argWritten[i] << summary->argCaptured[i] << " ";
+        rso << "\n  unknown " << summary->readsUnknownMemory << summary->writesUnknownMemory << "\n";
+        printGlobalNames(rso, "  read", summary->readGlobals);
+        printGlobalNames(rso, "  written", summary->writtenGlobals);
+      }
+      return rso.str();
+    }
+
+    static void printGlobalNames(raw_ostream &os, const char *label, const set<const GlobalVariable*> &globals){
+      vector<string> names;
+      for(const GlobalVariable *GV : globals){
+        string name;
+        raw_string_ostream nso(name);
+        GV->printAsOperand(nso, false);
+        names.push_back(nso.str());
+      }
+      std::sort(names.begin(), names.end());
+      os << label;
+      for(string &name : names)
+        os << " " << name;
+      os << "\n";
+    }
+
+    static void printAttributes(raw_ostream &os, AttributeList attrs, unsigned numArgs){
+      os << "  fn " << attrs.getAsString(AttributeList::FunctionIndex) << "\n";
+      for(unsigned i = 0; i < numArgs; ++i)
+        os << "  arg" << i << " " << attrs.getAsString(AttributeList::FirstArgIndex + i) << "\n";
+    }
+
+    bool loadFromCache(Function &F, string key, OmissionResult &R){
+      AnalysisCache::Entry entry;
+      if(!AnalysisCache(depCacheDir).load(key, entry))
+        return false;
+
+      vector<Instruction*> instructions;
+      vector<BasicBlock*> blocks;
+      for (inst_iterator I = inst_begin(F), SrcE = inst_end(F); I != SrcE; ++I)
+        instructions.push_back(&*I);
+      for (BasicBlock &BB : F)
+        blocks.push_back(&BB);
+      if(!entry.isValid(instructions.size(), blocks.size()))
+        return false;
+
+      errs() << "\tUsing cached results " << key << "\n";
+      for(auto &edge : entry.edges)
+        DG->addEdge(instructions[get<0>(edge)], instructions[get<1>(edge)], (EdgeDepType)get<2>(edge));
+      for(auto &pair : entry.omissions)
+        R.omittableInstructions[instructions[pair.first]] = (OmissionReason)pair.second;
+      for(auto &pair : entry.conditionalDeps)
+        R.conditionalDepMap[blocks[pair.first]] = pair.second;
+      for(auto &pair : entry.loopInvariant)
+        R.loopInvariantInstructions[instructions[pair.first]] = pair.second;
+      for(auto &pair : entry.ranges)
+        R.rangeInstructions[instructions[pair.first]] = pair.second;
+      for(auto &pair : entry.redundant)
+        R.redundantInstructions[instructions[pair.first]] = instructions[pair.second];
+      return true;
+    }
+
+    void storeToCache(Function &F, string key, OmissionResult &R){
+      AnalysisCache::Entry entry;
+      map<Instruction*, unsigned> instructionIndex;
+      map<BasicBlock*, unsigned> blockIndex;
+      for (inst_iterator I = inst_begin(F), SrcE = inst_end(F); I != SrcE; ++I)
+        instructionIndex[&*I] = entry.numInstructions++;
+      for (BasicBlock &BB : F)
+        blockIndex[&BB] = entry.numBlocks++;
+
+      for(auto edge : DG->getEdges())
+        entry.edges.push_back(make_tuple(instructionIndex[edge.getSrc()->getItem()], instructionIndex[edge.getDst()->getItem()], (unsigned)edge.getType()));
+      for(auto &pair : R.omittableInstructions)
+        entry.omissions[instructionIndex[pair.first]] = pair.second;
+      for(auto &pair : R.conditionalDepMap)
+        entry.conditionalDeps[blockIndex[pair.first]] = pair.second;
+      for(auto &pair : R.loopInvariantInstructions)
+        entry.loopInvariant[instructionIndex[pair.first]] = pair.second;
+      for(auto &pair : R.rangeInstructions)
+        entry.ranges[instructionIndex[pair.first]] = pair.second;
+      for(auto &pair : R.redundantInstructions)
+        entry.redundant[instructionIndex[pair.first]] = instructionIndex[pair.second];
+
+      if(!AnalysisCache(depCacheDir).store(key, entry))
+        errs() << "Problem writing cache entry " << key << "\n";
+    }
+
     void recursiveDepFinder(){
       // errs() << "recursiveDepFinder\n";
       vector<Instruction*>* checkedInstructions = new vector<Instruction*>();
       for(auto edge: CFG->getInEdges(CFG->getExit())){
-        recursiveDepFinderHelper1(checkedInstructions, edge->getSrc()->getItem());
+        if(overBudget())
+          return;
+        recursiveDepFinderHelper1(checkedInstructions, edge.getSrc());
       }
     }
 
-    void recursiveDepFinderHelper1(vector<Instruction*>* checkedInstructions, Instruction* I){
-      // errs() << "Checking dependencies for " << CFG->getNodeIndex(I) << "\n";
+    // Nodes are passed rather than instructions, the virtual entry node has none
+    void recursiveDepFinderHelper1(vector<Instruction*>* checkedInstructions, Node<Instruction*>* N){
+      ++visitedNodeCount;
+      ++Stats.visitedNodes;
+      if(overBudget())
+        return;
+      Instruction* I = N->getItem();
+      // errs() << "Checking dependencies for " << CFG->getNodeIndex(N) << "\n";
       checkedInstructions->push_back(I);
-      for(auto edge: CFG->getInEdges(I)){
+      for(auto edge: CFG->getInEdges(N)){
         if(isa<StoreInst>(I) || isa<LoadInst>(I)){
-          recursiveDepFinderHelper2(new vector<Instruction*>(), I, edge->getSrc()->getItem());
+          recursiveDepFinderHelper2(new vector<Instruction*>(), I, edge.getSrc());
         }
-        if(find(checkedInstructions->begin(), checkedInstructions->end(), edge->getSrc()->getItem()) == checkedInstructions->end()){
-          recursiveDepFinderHelper1(checkedInstructions, edge->getSrc()->getItem());
+        if(find(checkedInstructions->begin(), checkedInstructions->end(), edge.getSrc()->getItem()) == checkedInstructions->end()){
+          recursiveDepFinderHelper1(checkedInstructions, edge.getSrc());
         }else{
-          ;// errs() << "\tAlready checked " << CFG->getNodeIndex(edge->getSrc()->getItem()) << "\n";
+          ;// errs() << "\tAlready checked " << CFG->getNodeIndex(edge.getSrc()) << "\n";
         }
       }
     }
 
-    void recursiveDepFinderHelper2(vector<Instruction*>* checkedInstructions, Instruction* I, Instruction* C){
+    void recursiveDepFinderHelper2(vector<Instruction*>* checkedInstructions, Instruction* I, Node<Instruction*>* CN){
+      ++visitedNodeCount;
+      ++Stats.visitedNodes;
+      if(overBudget())
+        return;
+      Instruction* C = CN->getItem();
       checkedInstructions->push_back(C);
-      // errs() << "\t" <<  CFG->getNodeIndex(C) <<": ";
-      if(CFG->getNode(C) == CFG->getEntry()){
+      // errs() << "\t" <<  CFG->getNodeIndex(CN) <<": ";
+      if(CFG->isEntry(CN)){
         return;
       }
       if (DbgDeclareInst* DbgDeclare = dyn_cast<DbgDeclareInst>(C)) {
@@ -340,22 +1410,23 @@ namespace {
       }
       */
     
-      if(auto D = DI->depends(C, I, true)){
+      if(auto D = depends(C, I)){
+        bool carried = isLoopCarried(*D, C, I);
         if (D->isOutput())
         {
-            DG->addEdge(I, C, EdgeDepType::WAW);
+            DG->addEdge(I, C, carried ? EdgeDepType::WAWLC : EdgeDepType::WAW);
             // errs() << "WAW\n";
             return;
         }
         else if (D->isFlow())
         {
-            DG->addEdge(I, C, EdgeDepType::RAW);
+            DG->addEdge(I, C, carried ? EdgeDepType::RAWLC : EdgeDepType::RAW);
             // errs() << "RAW\n";
             return;
         }
         else if (D->isAnti())
         {
-            DG->addEdge(I, C, EdgeDepType::WAR);
+            DG->addEdge(I, C, carried ? EdgeDepType::WARLC : EdgeDepType::WAR);
             // errs() << "WAR\n";
             return;
         }else{
@@ -365,9 +1436,9 @@ namespace {
       }
       next:;
       
-      for(auto edge: CFG->getInEdges(C)){
-        if(find(checkedInstructions->begin(), checkedInstructions->end(), edge->getSrc()->getItem()) == checkedInstructions->end()){
-          recursiveDepFinderHelper2(checkedInstructions, I, edge->getSrc()->getItem());
+      for(auto edge: CFG->getInEdges(CN)){
+        if(find(checkedInstructions->begin(), checkedInstructions->end(), edge.getSrc()->getItem()) == checkedInstructions->end()){
+          recursiveDepFinderHelper2(checkedInstructions, I, edge.getSrc());
         }
       }
     }
@@ -441,5 +1512,38 @@ namespace {
 
 char DepAnalysis::ID = 0;
 
+FunctionPass *createDepAnalysisPass() { return new DepAnalysis(); }
+
+bool isSelectedFunction(StringRef name)
+{
+  if(depFunctions.empty())
+    return true;
+  static Regex filter("^(" + depFunctions + ")$");
+  return filter.match(name);
+}
+
+const char *getPhaseName(DepAnalysisPhase phase)
+{
+  switch(phase){
+    case PHASE_ESCAPE: return "escape";
+    case PHASE_CFG: return "cfg";
+    case PHASE_DEPS: return "deps";
+    case PHASE_OMISSION: return "omission";
+    case PHASE_OUTPUT: return "output";
+    default: return "?";
+  }
+}
+
+double getPhaseTime(DepAnalysisPhase phase)
+{
+  return phaseTimes[phase];
+}
+
+void resetPhaseTimes()
+{
+  for(double &t : phaseTimes)
+    t = 0;
+}
+
 static RegisterPass<DepAnalysis> X("dep-analysis", "Run the DepAnalysis algorithm. Generates a dependence graph", false, false);
 //static cl::opt<bool, false> printToDot("printToDot", cl::desc("Print dot file containing the depgraph"), cl::NotHidden);
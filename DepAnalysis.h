@@ -0,0 +1,35 @@
+#ifndef DEP_ANALYSIS_H
+#define DEP_ANALYSIS_H
+
+//LLVM IMPORTS
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Pass.h"
+
+using namespace llvm;
+
+// Creates the DepAnalysis pass ("dep-analysis")
+FunctionPass *createDepAnalysisPass();
+
+// Whether the function matches the -depFunctions filter
+bool isSelectedFunction(StringRef name);
+
+// Phases of DepAnalysis::runOnFunction whose wall-clock time is accumulated
+enum DepAnalysisPhase
+{
+	PHASE_ESCAPE,    // escape pre-pass / local omissions
+	PHASE_CFG,       // store/load CFG construction
+	PHASE_DEPS,      // dependence search
+	PHASE_OMISSION,  // conditional/loop/range/redundant classification
+	PHASE_OUTPUT,    // report, dot and binary output
+	NUM_PHASES
+};
+
+// Name of a phase, as printed by the benchmarks
+const char *getPhaseName(DepAnalysisPhase phase);
+
+// Seconds spent in each phase since the last resetPhaseTimes(), summed over
+// all analyzed functions
+double getPhaseTime(DepAnalysisPhase phase);
+void resetPhaseTimes();
+
+#endif // DEP_ANALYSIS_H
@@ -0,0 +1,354 @@
+//===- DepAnalysisBench.cpp - Scaling benchmarks for DepAnalysis ----------===//
+//
+// Generates synthetic functions of a controllable shape (number of loads and
+// stores, loop nesting depth, branch fan-out, number of distinct variables),
+// runs DepAnalysis on them and reports the time spent in each phase. One
+// shape parameter is doubled per step, and the log-log slope of every phase
+// is reported, so super-linear growth shows up as a slope well above 1.
+//
+// The generated code looks like clang -O0 output: variables live in allocas
+// (or globals) with dbg.declare, loops are for.cond/for.body/for.inc/for.end.
+//
+// The pass reports to stderr, run with 2>/dev/null to keep the terminal out
+// of the output timings. Graphs are written to -depOutputDir, a temporary
+// directory if none is given.
+//
+//===----------------------------------------------------------------------===//
+
+//LOCAL IMPORTS
+#include "DepAnalysis.h"
+
+//LLVM IMPORTS
+#include "llvm/Config/llvm-config.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/IR/DIBuilder.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/raw_ostream.h"
+
+//STL IMPORTS
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+static cl::opt<std::string> benchScale("benchScale", cl::desc("Shape parameter that is doubled per step: accesses, depth, fanout or vars"), cl::init("accesses"));
+static cl::opt<unsigned> benchAccesses("benchAccesses", cl::desc("Number of loads/stores in the loop body"), cl::init(64));
+static cl::opt<unsigned> benchDepth("benchDepth", cl::desc("Loop nesting depth"), cl::init(1));
+static cl::opt<unsigned> benchFanout("benchFanout", cl::desc("Number of successors of each branch in the loop body (1 = straight-line)"), cl::init(1));
+static cl::opt<unsigned> benchVars("benchVars", cl::desc("Number of distinct variables, every other one is a global"), cl::init(8));
+static cl::opt<unsigned> benchSteps("benchSteps", cl::desc("Number of sizes to sweep"), cl::init(6));
+static cl::opt<unsigned> benchRepeat("benchRepeat", cl::desc("Runs per size, the fastest one is reported"), cl::init(3));
+static cl::opt<double> benchMaxSlope("benchMaxSlope", cl::desc("Fail if the total time grows faster than size^slope (0 = no check)"), cl::init(0));
+
+struct BenchShape
+{
+	unsigned accesses, depth, fanout, vars;
+};
+
+// Builds "void bench()" with the given shape, in the style of clang -O0
+class BenchGenerator
+{
+	Module &M;
+	IRBuilder<> B;
+	DIBuilder DIB;
+	BenchShape shape;
+	Function *F;
+	DISubprogram *SP;
+	DIFile *file;
+	DIType *intType;
+	std::vector<Value*> vars;
+	std::vector<AllocaInst*> counters;
+	unsigned line = 1;
+	unsigned statement = 0;
+	unsigned emitted = 0;
+
+	void setLocation()
+	{
+		B.SetCurrentDebugLocation(DILocation::get(M.getContext(), line++, 3, SP));
+	}
+
+	AllocaInst *createLocal(std::string name, BasicBlock *entry)
+	{
+		setLocation();
+		AllocaInst *alloca = B.CreateAlloca(B.getInt32Ty(), nullptr, name);
+		DILocalVariable *var = DIB.createAutoVariable(SP, name, file, line, intType);
+		DIB.insertDeclare(alloca, var, DIB.createExpression(), DILocation::get(M.getContext(), line, 3, SP), entry);
+		return alloca;
+	}
+
+	// v_dst = v_src + 1
+	void emitStatement()
+	{
+		unsigned n = vars.size();
+		Value *src = vars[(statement * 7 + 3) % n];
+		Value *dst = vars[(statement * 13 + 1) % n];
+		++statement;
+		setLocation();
+		Value *val = B.CreateLoad(B.getInt32Ty(), src);
+		B.CreateStore(B.CreateAdd(val, B.getInt32(1)), dst);
+		emitted += 2;
+	}
+
+	// switch(v) over fanout cases with two statements each
+	void emitBranch()
+	{
+		LLVMContext &C = M.getContext();
+		setLocation();
+		Value *sel = B.CreateLoad(B.getInt32Ty(), vars[statement % vars.size()]);
+		++emitted;
+		BasicBlock *merge = BasicBlock::Create(C, "sw.epilog", F);
+		SwitchInst *sw = B.CreateSwitch(sel, merge, shape.fanout);
+		for (unsigned i = 0; i < shape.fanout; ++i)
+		{
+			BasicBlock *bb = BasicBlock::Create(C, "sw.bb", F, merge);
+			sw->addCase(B.getInt32(i), bb);
+			B.SetInsertPoint(bb);
+			emitStatement();
+			emitStatement();
+			B.CreateBr(merge);
+		}
+		B.SetInsertPoint(merge);
+	}
+
+	void emitBody()
+	{
+		while (emitted < shape.accesses)
+		{
+			if (shape.fanout > 1)
+				emitBranch();
+			else
+				emitStatement();
+		}
+	}
+
+	// for (i = 0; i < 100; ++i) { ... }
+	void emitLoop(unsigned level)
+	{
+		LLVMContext &C = M.getContext();
+		AllocaInst *i = counters[level];
+		BasicBlock *cond = BasicBlock::Create(C, "for.cond", F);
+		BasicBlock *body = BasicBlock::Create(C, "for.body", F);
+		BasicBlock *inc = BasicBlock::Create(C, "for.inc", F);
+		BasicBlock *end = BasicBlock::Create(C, "for.end", F);
+
+		setLocation();
+		B.CreateStore(B.getInt32(0), i);
+		B.CreateBr(cond);
+
+		B.SetInsertPoint(cond);
+		setLocation();
+		Value *cmp = B.CreateICmpSLT(B.CreateLoad(B.getInt32Ty(), i), B.getInt32(100));
+		B.CreateCondBr(cmp, body, end);
+
+		B.SetInsertPoint(body);
+		if (level + 1 < shape.depth)
+			emitLoop(level + 1);
+		else
+			emitBody();
+		B.CreateBr(inc);
+
+		// Keep the blocks in source order
+		inc->moveAfter(B.GetInsertBlock());
+		end->moveAfter(inc);
+		B.SetInsertPoint(inc);
+		setLocation();
+		B.CreateStore(B.CreateAdd(B.CreateLoad(B.getInt32Ty(), i), B.getInt32(1)), i);
+		B.CreateBr(cond);
+
+		B.SetInsertPoint(end);
+	}
+
+public:
+	BenchGenerator(Module &M, BenchShape shape) : M(M), B(M.getContext()), DIB(M), shape(shape) {}
+
+	Function *generate()
+	{
+		LLVMContext &C = M.getContext();
+		M.addModuleFlag(Module::Warning, "Debug Info Version", DEBUG_METADATA_VERSION);
+		file = DIB.createFile("bench.c", ".");
+		DIB.createCompileUnit(dwarf::DW_LANG_C99, file, "DepAnalysisBench", false, "", 0);
+		intType = DIB.createBasicType("int", 32, dwarf::DW_ATE_signed);
+		DISubroutineType *fnType = DIB.createSubroutineType(DIB.getOrCreateTypeArray(None));
+
+		F = Function::Create(FunctionType::get(B.getVoidTy(), false), GlobalValue::ExternalLinkage, "bench", &M);
+#if LLVM_VERSION_MAJOR >= 8
+		SP = DIB.createFunction(file, "bench", "bench", file, line, fnType, line, DINode::FlagZero, DISubprogram::SPFlagDefinition);
+#else
+		SP = DIB.createFunction(file, "bench", "bench", file, line, fnType, false, true, line);
+#endif
+		F->setSubprogram(SP);
+
+		BasicBlock *entry = BasicBlock::Create(C, "entry", F);
+		B.SetInsertPoint(entry);
+		for (unsigned v = 0; v < std::max(shape.vars, 1u); ++v)
+		{
+			std::string name = "v" + std::to_string(v);
+			if (v % 2)
+				vars.push_back(new GlobalVariable(M, B.getInt32Ty(), false, GlobalValue::CommonLinkage, B.getInt32(0), name));
+			else
+				vars.push_back(createLocal(name, entry));
+		}
+		for (unsigned d = 0; d < shape.depth; ++d)
+			counters.push_back(createLocal("i" + std::to_string(d), entry));
+		for (Value *v : vars)
+		{
+			if (isa<AllocaInst>(v))
+			{
+				setLocation();
+				B.CreateStore(B.getInt32(0), v);
+			}
+		}
+
+		if (shape.depth > 0)
+			emitLoop(0);
+		else
+			emitBody();
+		setLocation();
+		B.CreateRetVoid();
+		DIB.finalize();
+		return F;
+	}
+};
+
+static unsigned &scaledParameter(BenchShape &shape)
+{
+	if (benchScale == "depth")
+		return shape.depth;
+	if (benchScale == "fanout")
+		return shape.fanout;
+	if (benchScale == "vars")
+		return shape.vars;
+	return shape.accesses;
+}
+
+// Fastest of benchRepeat runs, per phase
+static std::vector<double> runShape(BenchShape shape, unsigned &numAccesses)
+{
+	std::vector<double> best(NUM_PHASES, -1);
+	for (unsigned r = 0; r < std::max(benchRepeat.getValue(), 1u); ++r)
+	{
+		LLVMContext context;
+		Module M("bench", context);
+		Function *F = BenchGenerator(M, shape).generate();
+		numAccesses = 0;
+		for (BasicBlock &BB : *F)
+			for (Instruction &I : BB)
+				numAccesses += isa<LoadInst>(I) || isa<StoreInst>(I);
+
+		resetPhaseTimes();
+		legacy::PassManager PM;
+		PM.add(createDepAnalysisPass());
+		PM.run(M);
+		for (unsigned p = 0; p < NUM_PHASES; ++p)
+		{
+			double t = getPhaseTime((DepAnalysisPhase)p);
+			if (best[p] < 0 || t < best[p])
+				best[p] = t;
+		}
+	}
+	return best;
+}
+
+// Least-squares slope of log(time) over log(size)
+static double logLogSlope(const std::vector<double> &sizes, const std::vector<double> &times)
+{
+	double n = 0, sx = 0, sy = 0, sxx = 0, sxy = 0;
+	for (size_t i = 0; i < sizes.size(); ++i)
+	{
+		if (times[i] <= 0)
+			continue;
+		double x = std::log(sizes[i]), y = std::log(times[i]);
+		n += 1;
+		sx += x;
+		sy += y;
+		sxx += x * x;
+		sxy += x * y;
+	}
+	double d = n * sxx - sx * sx;
+	return (n < 2 || d == 0) ? 0 : (n * sxy - sx * sy) / d;
+}
+
+int main(int argc, char **argv)
+{
+	InitLLVM X(argc, argv);
+	// Default -depOutputDir to a scratch directory
+	std::vector<const char*> args(argv, argv + argc);
+	SmallString<128> scratch;
+	std::string outputArg;
+	if (std::none_of(args.begin(), args.end(), [](const char *a) { return StringRef(a).contains("depOutputDir"); }))
+	{
+		if (std::error_code ec = sys::fs::createUniqueDirectory("dep-analysis-bench", scratch))
+		{
+			errs() << "Can't create scratch directory: " << ec.message() << "\n";
+			return 1;
+		}
+		outputArg = "-depOutputDir=" + scratch.str().str();
+		args.push_back(outputArg.c_str());
+	}
+	cl::ParseCommandLineOptions(args.size(), args.data(), "DepAnalysis scaling benchmarks\n");
+	if (benchScale != "accesses" && benchScale != "depth" && benchScale != "fanout" && benchScale != "vars")
+	{
+		errs() << "Unknown -benchScale " << benchScale << "\n";
+		return 1;
+	}
+
+	PassRegistry &registry = *PassRegistry::getPassRegistry();
+	initializeCore(registry);
+	initializeAnalysis(registry);
+
+	BenchShape shape = {benchAccesses, benchDepth, benchFanout, benchVars};
+	unsigned &param = scaledParameter(shape);
+	param = std::max(param, 1u);
+
+	outs() << "Scaling " << benchScale << " (accesses=" << shape.accesses << " depth=" << shape.depth
+	       << " fanout=" << shape.fanout << " vars=" << shape.vars << ")\n";
+	outs() << format("%10s %10s", benchScale.c_str(), (const char*)"ld/st");
+	for (unsigned p = 0; p < NUM_PHASES; ++p)
+		outs() << format(" %10s", getPhaseName((DepAnalysisPhase)p));
+	outs() << format(" %10s\n", (const char*)"total");
+
+	std::vector<double> sizes;
+	std::vector<std::vector<double>> times(NUM_PHASES + 1);
+	for (unsigned step = 0; step < benchSteps; ++step, param *= 2)
+	{
+		unsigned numAccesses;
+		std::vector<double> t = runShape(shape, numAccesses);
+		double total = 0;
+		outs() << format("%10u %10u", param, numAccesses);
+		for (unsigned p = 0; p < NUM_PHASES; ++p)
+		{
+			outs() << format(" %10.4f", t[p]);
+			times[p].push_back(t[p]);
+			total += t[p];
+		}
+		outs() << format(" %10.4f\n", total);
+		times[NUM_PHASES].push_back(total);
+		sizes.push_back(param);
+		outs().flush();
+	}
+
+	outs() << format("%21s", (const char*)"slope");
+	for (unsigned p = 0; p <= NUM_PHASES; ++p)
+		outs() << format(" %10.2f", logLogSlope(sizes, times[p]));
+	outs() << "\n";
+
+	if (!scratch.empty())
+		sys::fs::remove_directories(scratch);
+
+	double slope = logLogSlope(sizes, times[NUM_PHASES]);
+	if (benchMaxSlope > 0 && slope > benchMaxSlope)
+	{
+		errs() << "Total time grows with slope " << format("%.2f", slope) << " > " << benchMaxSlope.getValue() << "\n";
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,89 @@
+//===- DepAnalysisDriver.cpp - Standalone driver for DepAnalysis ----------===//
+//
+// Runs DepAnalysis on a bitcode file without opt. The module is loaded lazily
+// and only the function bodies selected by -depFunctions are materialized;
+// all other functions are turned into declarations. Their callers fall back to
+// the declarations' attributes, and since writes in dropped bodies are not
+// visible, only constant globals are taken as read-only. Results are written
+// to -depOutputDir.
+//
+//===----------------------------------------------------------------------===//
+
+//LOCAL IMPORTS
+#include "DepAnalysis.h"
+#include "FunctionSummary.h"
+
+//LLVM IMPORTS
+#include "llvm/InitializePasses.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+
+static cl::opt<std::string> inputFilename(cl::Positional, cl::desc("<input bitcode file>"), cl::init("-"), cl::value_desc("filename"));
+
+int main(int argc, char **argv)
+{
+	InitLLVM X(argc, argv);
+	cl::ParseCommandLineOptions(argc, argv, "DepAnalysis driver\n\n"
+		"  Callees that are not selected are treated as external functions.\n");
+
+	LLVMContext context;
+	SMDiagnostic err;
+	std::unique_ptr<Module> M = getLazyIRFileModule(inputFilename, err, context);
+	if (!M)
+	{
+		err.print(argv[0], errs());
+		return 1;
+	}
+	if (Error e = M->materializeMetadata())
+	{
+		logAllUnhandledErrors(std::move(e), errs(), "Problem loading metadata: ");
+		return 1;
+	}
+
+	unsigned selected = 0;
+	bool bodiesDropped = false;
+	for (Function &F : *M)
+	{
+		if (F.isDeclaration())
+			continue;
+		if (!isSelectedFunction(F.getName()))
+		{
+			// Never materialized, or dropped right away
+			F.deleteBody();
+			F.setComdat(nullptr);
+			bodiesDropped = true;
+			continue;
+		}
+		if (Error e = F.materialize())
+		{
+			logAllUnhandledErrors(std::move(e), errs(), "Problem loading " + F.getName().str() + ": ");
+			return 1;
+		}
+		++selected;
+	}
+	if (selected == 0)
+	{
+		errs() << "No function matches the filter\n";
+		return 1;
+	}
+
+	PassRegistry &registry = *PassRegistry::getPassRegistry();
+	initializeCore(registry);
+	initializeAnalysis(registry);
+
+	legacy::PassManager PM;
+	// Scheduled explicitly to tell it about the dropped bodies
+	PM.add(new FunctionSummaryPass(bodiesDropped));
+	PM.add(createDepAnalysisPass());
+	PM.run(*M);
+	return 0;
+}
@@ -0,0 +1,230 @@
+//===- DepMerge.cpp - Merge static and dynamic DiscoPoP dependences -------===//
+//
+// Merges a DiscoPoP dependence profile with the static dependences written by
+// DepAnalysis (-depExport) into one dependence file. The static dependences
+// stand in for the accesses DepAnalysis omitted from instrumentation.
+//
+// Inputs of any size are merged in bounded memory with an external sort:
+// records are read in order of the inputs into a buffer of -mergeBufferMB,
+// which is sorted and spilled to a temporary run file whenever it is full.
+// The runs are then combined by k-way merges of at most -mergeMaxRuns files.
+// If everything fits into the buffer, no temporary files are written.
+//
+// As in -depExportMerge, records are ordered by file and line, the NOM lines
+// of a location are unioned and all other lines (BGN, END, ...) are passed
+// through in input order.
+//
+//===----------------------------------------------------------------------===//
+
+//LOCAL IMPORTS
+#include "DPDepFile.h"
+
+//LLVM IMPORTS
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+//STL IMPORTS
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+static cl::list<std::string> inputFilenames(cl::Positional, cl::desc("<profile> <static dependence files>..."), cl::OneOrMore);
+static cl::opt<std::string> outputFilename("o", cl::desc("Output file"), cl::init("-"), cl::value_desc("filename"));
+static cl::opt<unsigned> mergeBufferMB("mergeBufferMB", cl::desc("Memory for sorting records before they are spilled to a run file"), cl::init(256));
+static cl::opt<unsigned> mergeMaxRuns("mergeMaxRuns", cl::desc("Most run files merged at once"), cl::init(64));
+static cl::opt<std::string> mergeTempDir("mergeTempDir", cl::desc("Directory of the temporary run files (default: system temp directory)"), cl::value_desc("directory"));
+
+// Sorted runs of the inputs, in memory or spilled to temporary files
+class RunBuilder
+{
+private:
+	std::vector<DPDepRecord> buffer;
+	uint64_t bufferBytes = 0;
+	uint64_t maxBytes;
+	std::vector<std::string> runFiles;
+	bool failed = false;
+
+public:
+	uint64_t records = 0;
+
+	RunBuilder(uint64_t maxBytes)
+		: maxBytes(maxBytes)
+		{}
+
+	~RunBuilder()
+	{
+		for (const std::string &file : runFiles)
+			sys::fs::remove(file);
+	}
+
+	bool hasFailed() const { return failed; }
+	size_t getNumRuns() const { return runFiles.size() + !buffer.empty(); }
+
+	// Rough heap size of a record
+	static uint64_t recordBytes(const DPDepRecord &record)
+	{
+		uint64_t bytes = sizeof(DPDepRecord) + record.kind.size() + record.rest.size();
+		for (const std::string &dep : record.deps)
+			bytes += dep.size() + 48;
+		return bytes;
+	}
+
+	// Opens a new run file, the caller records it for cleanup
+	bool createRunFile(std::unique_ptr<raw_fd_ostream> &stream, std::string &file)
+	{
+		SmallString<128> model;
+		if (mergeTempDir.empty())
+			sys::path::system_temp_directory(true, model);
+		else
+			model = mergeTempDir;
+		sys::path::append(model, "dep-merge-%%%%%%%%.run");
+		int fd;
+		SmallString<128> path;
+		if (std::error_code EC = sys::fs::createUniqueFile(model, fd, path))
+		{
+			errs() << "Problem creating a run file in " << sys::path::parent_path(model) << ": " << EC.message() << "\n";
+			failed = true;
+			return false;
+		}
+		stream.reset(new raw_fd_ostream(fd, true));
+		file = path.str().str();
+		return true;
+	}
+
+	// Stable, so records of one location stay in input order
+	void spill()
+	{
+		if (buffer.empty())
+			return;
+		std::stable_sort(buffer.begin(), buffer.end());
+		std::unique_ptr<raw_fd_ostream> stream;
+		std::string file;
+		if (!createRunFile(stream, file))
+			return;
+		runFiles.push_back(file);
+		for (const DPDepRecord &record : buffer)
+			record.print(*stream);
+		buffer.clear();
+		bufferBytes = 0;
+	}
+
+	void add(DPDepRecord &&record)
+	{
+		++records;
+		bufferBytes += recordBytes(record);
+		buffer.push_back(std::move(record));
+		if (bufferBytes >= maxBytes)
+			spill();
+	}
+
+	// Merges run files until at most mergeMaxRuns are left. Runs are merged
+	// in their order, so ties between runs still resolve in input order
+	void reduceRuns()
+	{
+		size_t maxRuns = std::max(2u, (unsigned)mergeMaxRuns);
+		// The in-memory buffer is one more run
+		while (!failed && runFiles.size() + !buffer.empty() > maxRuns)
+		{
+			std::vector<std::string> merged;
+			for (size_t first = 0; first < runFiles.size() && !failed; first += maxRuns)
+			{
+				size_t last = std::min(first + maxRuns, runFiles.size());
+				if (last - first == 1)
+				{
+					merged.push_back(runFiles[first]);
+					continue;
+				}
+				std::vector<std::unique_ptr<DPDepFileSource>> owned;
+				std::vector<DPDepSource*> sources;
+				for (size_t i = first; i < last; ++i)
+				{
+					owned.emplace_back(new DPDepFileSource(runFiles[i]));
+					sources.push_back(owned.back().get());
+				}
+				std::unique_ptr<raw_fd_ostream> stream;
+				std::string file;
+				if (!createRunFile(stream, file))
+					break;
+				merged.push_back(file);
+				mergeDPDeps(sources, *stream);
+			}
+			if (failed)
+			{
+				runFiles.insert(runFiles.end(), merged.begin(), merged.end());
+				return;
+			}
+			for (const std::string &file : runFiles)
+				if (std::find(merged.begin(), merged.end(), file) == merged.end())
+					sys::fs::remove(file);
+			runFiles.swap(merged);
+		}
+	}
+
+	// Merges all runs into out, returns the number of written lines
+	uint64_t merge(raw_ostream &out)
+	{
+		std::stable_sort(buffer.begin(), buffer.end());
+		std::vector<std::unique_ptr<DPDepSource>> owned;
+		std::vector<DPDepSource*> sources;
+		for (const std::string &file : runFiles)
+		{
+			owned.emplace_back(new DPDepFileSource(file));
+			sources.push_back(owned.back().get());
+		}
+		// The buffer holds the last records that were read
+		owned.emplace_back(new DPDepVectorSource(std::move(buffer)));
+		sources.push_back(owned.back().get());
+		return mergeDPDeps(sources, out);
+	}
+};
+
+int main(int argc, char **argv)
+{
+	InitLLVM X(argc, argv);
+	cl::ParseCommandLineOptions(argc, argv, "DiscoPoP dependence merge\n\n"
+		"  Merges a dependence profile with the static dependences of DepAnalysis\n"
+		"  (-depExport). List the profile first, its lines come first at each location.\n");
+
+	RunBuilder runs((uint64_t)mergeBufferMB << 20);
+	for (const std::string &fileName : inputFilenames)
+	{
+		DPDepFileSource source(fileName);
+		if (!source.isOpen())
+		{
+			errs() << "Problem opening file: " << fileName << "\n";
+			return 1;
+		}
+		DPDepRecord record;
+		while (source.next(record) && !runs.hasFailed())
+			runs.add(std::move(record));
+	}
+	size_t numRuns = runs.getNumRuns();
+	runs.reduceRuns();
+	if (runs.hasFailed())
+		return 1;
+
+	std::error_code EC;
+	raw_fd_ostream out(outputFilename, EC);
+	if (EC)
+	{
+		errs() << "Problem opening file: " << outputFilename << " (" << EC.message() << ")\n";
+		return 1;
+	}
+	uint64_t lines = runs.merge(out);
+	out.close();
+	if (out.has_error())
+	{
+		out.clear_error();
+		errs() << "Problem writing file: " << outputFilename << "\n";
+		return 1;
+	}
+	errs() << "Merged " << runs.records << " records of " << inputFilenames.size() << " files in "
+		<< numRuns << " runs into " << lines << " lines\n";
+	return 0;
+}
@@ -11,6 +11,8 @@ enum EdgeDepType {RAR,
 									RAWLC, 
 									PARENT, 
 									RECURSIVE,
-									FCALL};
+									FCALL,
+									WARLC,
+									WAWLC};
 
 #endif // EDGE_DEP_TYPE_ENUM_H
\ No newline at end of file
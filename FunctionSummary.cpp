@@ -0,0 +1,373 @@
+//LOCAL IMPORTS
+#include "FunctionSummary.h"
+
+//LLVM IMPORTS
+#include "llvm/ADT/SCCIterator.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/IR/InstIterator.h"
+
+#define DEBUG_TYPE "dep-analysis"
+
+char FunctionSummaryPass::ID = 0;
+
+static RegisterPass<FunctionSummaryPass> Y("function-summary", "Compute memory-effect summaries for DepAnalysis", false, true);
+static cl::opt<bool, false> wholeProgram("wholeProgram", cl::desc("Assume globals are not written outside of the analyzed module"), cl::NotHidden);
+
+void FunctionSummaryPass::getAnalysisUsage(AnalysisUsage &AU) const
+{
+	AU.setPreservesAll();
+	AU.addRequired<CallGraphWrapperPass>();
+}
+
+bool FunctionSummaryPass::runOnModule(Module &M)
+{
+	summaries.clear();
+	CallGraph &CG = getAnalysis<CallGraphWrapperPass>().getCallGraph();
+
+	// scc_iterator visits callees before their callers
+	for (scc_iterator<CallGraph*> SCC = scc_begin(&CG); !SCC.isAtEnd(); ++SCC)
+	{
+		vector<Function*> functions;
+		for (CallGraphNode *node : *SCC)
+		{
+			Function *F = node->getFunction();
+			if (F && !F->isDeclaration())
+			{
+				functions.push_back(F);
+				summaries[F] = FunctionSummary(F->arg_size());
+			}
+		}
+
+		bool changed = true;
+		while (changed)
+		{
+			changed = false;
+			for (Function *F : functions)
+			{
+				FunctionSummary S = computeSummary(*F);
+				if (S != summaries[F])
+				{
+					summaries[F] = S;
+					changed = true;
+				}
+			}
+		}
+	}
+
+	readOnlyGlobals.clear();
+	for (GlobalVariable &GV : M.globals())
+	{
+		if (GV.isConstant())
+			readOnlyGlobals.insert(&GV);
+		else if (!bodiesDropped && GV.hasDefinitiveInitializer() && (GV.hasLocalLinkage() || wholeProgram) && isOnlyRead(&GV))
+			readOnlyGlobals.insert(&GV);
+	}
+	return false;
+}
+
+// Every use of ptr (or of addresses derived from it) only reads the memory
+bool FunctionSummaryPass::isOnlyRead(const Value *ptr) const
+{
+	for (const Use &U : ptr->uses())
+	{
+		const User *user = U.getUser();
+		if (isa<GEPOperator>(user) || Operator::getOpcode(user) == Instruction::BitCast)
+		{
+			if (!isOnlyRead(user))
+				return false;
+		}
+		else if (const CallBase *call = dyn_cast<CallBase>(user))
+		{
+			if (isa<DbgInfoIntrinsic>(call))
+				continue;
+			if (!call->isArgOperand(&U))
+				return false;
+			unsigned i = call->getArgOperandNo(&U);
+			if (callMayWriteArg(call, i) || callMayCaptureArg(call, i))
+				return false;
+		}
+		else if (!isa<LoadInst>(user) && !isa<ICmpInst>(user))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// The argument a local only holds a copy of. clang -O0 spills every parameter
+// to a slot (%p.addr) that is stored once and then only loaded from
+static Argument *getSpilledArgument(AllocaInst *slot)
+{
+	Argument *arg = nullptr;
+	for (Use &U : slot->uses())
+	{
+		User *user = U.getUser();
+		if (isa<LoadInst>(user))
+			continue;
+		StoreInst *store = dyn_cast<StoreInst>(user);
+		if (!store || U.getOperandNo() != 1 || arg || !isa<Argument>(store->getValueOperand()))
+			return nullptr;
+		arg = cast<Argument>(store->getValueOperand());
+	}
+	return arg;
+}
+
+// A load of the spill slot of an argument, see getSpilledArgument
+static bool isArgumentCopy(Value *v)
+{
+	LoadInst *load = dyn_cast<LoadInst>(v);
+	AllocaInst *slot = load ? dyn_cast<AllocaInst>(load->getPointerOperand()) : nullptr;
+	return slot && getSpilledArgument(slot);
+}
+
+// Records an access of the object base. Arguments (and their copies) are
+// handled by addPointerEffects, locals stay local
+static void addObjectAccess(Value *base, bool isRead, bool isWrite, FunctionSummary &S)
+{
+	if (GlobalVariable *GV = dyn_cast<GlobalVariable>(base))
+	{
+		if (isRead) S.readGlobals.insert(GV);
+		if (isWrite) S.writtenGlobals.insert(GV);
+	}
+	else if (!isa<Argument>(base) && !isa<AllocaInst>(base) && !isArgumentCopy(base))
+	{
+		S.readsUnknownMemory |= isRead;
+		S.writesUnknownMemory |= isWrite;
+	}
+}
+
+FunctionSummary FunctionSummaryPass::computeSummary(Function &F)
+{
+	FunctionSummary S(F.arg_size());
+
+	for (Argument &A : F.args())
+	{
+		if (A.getType()->isPointerTy())
+			addPointerEffects(&A, A.getArgNo(), S);
+	}
+
+	for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I)
+	{
+		if (isa<LoadInst>(&*I) || isa<StoreInst>(&*I))
+		{
+			bool isWrite = isa<StoreInst>(&*I);
+			addObjectAccess(getBaseObject(I->getOperand(isWrite ? 1 : 0)), !isWrite, isWrite, S);
+		}
+		else if (isa<AtomicRMWInst>(&*I) || isa<AtomicCmpXchgInst>(&*I))
+		{
+			// Operand 0 is the address, it is read and written
+			addObjectAccess(getBaseObject(I->getOperand(0)), true, true, S);
+		}
+		else if (CallBase *call = dyn_cast<CallBase>(&*I))
+		{
+			if (isa<DbgInfoIntrinsic>(call) || call->doesNotAccessMemory())
+				continue;
+
+			const FunctionSummary *callee = getSummary(call->getCalledFunction());
+			if (callee)
+			{
+				S.readGlobals.insert(callee->readGlobals.begin(), callee->readGlobals.end());
+				S.writtenGlobals.insert(callee->writtenGlobals.begin(), callee->writtenGlobals.end());
+				S.readsUnknownMemory |= callee->readsUnknownMemory;
+				S.writesUnknownMemory |= callee->writesUnknownMemory;
+			}
+			else if (!call->onlyAccessesArgMemory())
+			{
+				S.readsUnknownMemory = true;
+				S.writesUnknownMemory |= !call->onlyReadsMemory();
+			}
+
+			// Memory reached through the arguments. Arguments of F and their
+			// copies are handled by addPointerEffects, locals stay local.
+			for (unsigned i = 0; i < call->arg_size(); ++i)
+			{
+				Value *base = getBaseObject(call->getArgOperand(i));
+				if (!base->getType()->isPointerTy() || isa<Argument>(base) || isa<AllocaInst>(base) || isArgumentCopy(base))
+					continue;
+				GlobalVariable *GV = dyn_cast<GlobalVariable>(base);
+				if (callMayReadArg(call, i))
+				{
+					if (GV) S.readGlobals.insert(GV);
+					else S.readsUnknownMemory = true;
+				}
+				if (callMayWriteArg(call, i))
+				{
+					if (GV) S.writtenGlobals.insert(GV);
+					else S.writesUnknownMemory = true;
+				}
+			}
+		}
+		else if (I->mayReadOrWriteMemory())
+		{
+			// Fences, va_arg, ...: effects that are not modelled
+			S.readsUnknownMemory |= I->mayReadFromMemory();
+			S.writesUnknownMemory |= I->mayWriteToMemory();
+		}
+	}
+	return S;
+}
+
+// Follows the uses of (a pointer derived from) argument argNo
+void FunctionSummaryPass::addPointerEffects(Value *ptr, unsigned argNo, FunctionSummary &S)
+{
+	for (Use &U : ptr->uses())
+	{
+		User *user = U.getUser();
+		if (isa<GEPOperator>(user) || Operator::getOpcode(user) == Instruction::BitCast)
+		{
+			addPointerEffects(user, argNo, S);
+		}
+		else if (isa<LoadInst>(user))
+		{
+			S.argRead[argNo] = true;
+		}
+		else if (StoreInst *store = dyn_cast<StoreInst>(user))
+		{
+			AllocaInst *slot = dyn_cast<AllocaInst>(store->getPointerOperand());
+			if (U.getOperandNo() == 1)
+			{
+				S.argWritten[argNo] = true;
+			}
+			else if (slot && getSpilledArgument(slot) == ptr)
+			{
+				// Spilled, the loads of the slot are copies of the argument
+				for (User *slotUser : slot->users())
+				{
+					if (isa<LoadInst>(slotUser))
+						addPointerEffects(slotUser, argNo, S);
+				}
+			}
+			else
+			{
+				S.argCaptured[argNo] = true;
+			}
+		}
+		else if (CallBase *call = dyn_cast<CallBase>(user))
+		{
+			if (isa<DbgInfoIntrinsic>(call))
+				continue;
+			if (!call->isArgOperand(&U))
+			{
+				// Called or a bundle operand, not passed
+				S.argRead[argNo] = S.argWritten[argNo] = S.argCaptured[argNo] = true;
+				continue;
+			}
+			unsigned i = call->getArgOperandNo(&U);
+			if (callMayReadArg(call, i)) S.argRead[argNo] = true;
+			if (callMayWriteArg(call, i)) S.argWritten[argNo] = true;
+			if (callMayCaptureArg(call, i)) S.argCaptured[argNo] = true;
+		}
+		else if (!isa<ICmpInst>(user))
+		{
+			// Returned, merged by PHIs/selects, converted to integers, ...
+			S.argRead[argNo] = S.argWritten[argNo] = S.argCaptured[argNo] = true;
+		}
+	}
+}
+
+const FunctionSummary *FunctionSummaryPass::getSummary(const Function *F) const
+{
+	if (F == nullptr)
+		return nullptr;
+	auto it = summaries.find(F);
+	if (it == summaries.end())
+		return nullptr;
+	return &it->second;
+}
+
+bool FunctionSummaryPass::callMayReadArg(const CallBase *call, unsigned argNo) const
+{
+	const FunctionSummary *S = getSummary(call->getCalledFunction());
+	if (S && argNo < S->argRead.size())
+		return S->argRead[argNo];
+	return !call->doesNotAccessMemory() && !call->doesNotAccessMemory(argNo);
+}
+
+bool FunctionSummaryPass::callMayWriteArg(const CallBase *call, unsigned argNo) const
+{
+	const FunctionSummary *S = getSummary(call->getCalledFunction());
+	if (S && argNo < S->argWritten.size())
+		return S->argWritten[argNo];
+	return !call->onlyReadsMemory() && !call->onlyReadsMemory(argNo);
+}
+
+bool FunctionSummaryPass::callMayCaptureArg(const CallBase *call, unsigned argNo) const
+{
+	const FunctionSummary *S = getSummary(call->getCalledFunction());
+	if (S && argNo < S->argCaptured.size())
+		return S->argCaptured[argNo];
+	return !call->doesNotCapture(argNo);
+}
+
+bool FunctionSummaryPass::callMayWriteObject(const CallBase *call, const Value *base, bool baseEscaped) const
+{
+	if (isa<DbgInfoIntrinsic>(call) || call->onlyReadsMemory())
+		return false;
+
+	for (unsigned i = 0; i < call->arg_size(); ++i)
+	{
+		Value *arg = call->getArgOperand(i);
+		if (!arg->getType()->isPointerTy() || !callMayWriteArg(call, i))
+			continue;
+		Value *argBase = getBaseObject(arg);
+		if (argBase == base)
+			return true;
+		// A pointer of unknown origin may point to anything that escaped
+		if (baseEscaped && !isa<AllocaInst>(argBase) && !isa<GlobalVariable>(argBase))
+			return true;
+	}
+	if (isa<AllocaInst>(base) && !baseEscaped)
+		return false;
+
+	const FunctionSummary *S = getSummary(call->getCalledFunction());
+	if (S == nullptr)
+		return !call->onlyAccessesArgMemory();
+	if (const GlobalVariable *GV = dyn_cast<GlobalVariable>(base))
+		return S->writtenGlobals.count(GV) || S->writesUnknownMemory;
+	if (isa<AllocaInst>(base))
+		return S->writesUnknownMemory;
+	return !S->writtenGlobals.empty() || S->writesUnknownMemory;
+}
+
+Value *FunctionSummaryPass::getBaseObject(Value *v)
+{
+	while (true)
+	{
+		if (GEPOperator *gep = dyn_cast<GEPOperator>(v))
+			v = gep->getPointerOperand();
+		else if (Operator::getOpcode(v) == Instruction::BitCast)
+			v = cast<Operator>(v)->getOperand(0);
+		else
+			return v;
+	}
+}
+
+void FunctionSummaryPass::print(raw_ostream &O, const Module *M) const
+{
+	// In module order, the map is ordered by address
+	for (const Function &F : *M)
+	{
+		const FunctionSummary *summary = getSummary(&F);
+		if (summary == nullptr)
+			continue;
+		const FunctionSummary &S = *summary;
+		O << F.getName() << ":\n";
+		for (unsigned i = 0; i < S.argRead.size(); ++i)
+		{
+			O << "\targ " << i << ":"
+				<< (S.argRead[i] ? " read" : "")
+				<< (S.argWritten[i] ? " written" : "")
+				<< (S.argCaptured[i] ? " captured" : "")
+				<< "\n";
+		}
+		for (const GlobalVariable *GV : S.readGlobals)
+			O << "\tread " << GV->getName() << "\n";
+		for (const GlobalVariable *GV : S.writtenGlobals)
+			O << "\twrite " << GV->getName() << "\n";
+		if (S.readsUnknownMemory) O << "\treads unknown memory\n";
+		if (S.writesUnknownMemory) O << "\twrites unknown memory\n";
+	}
+	O << "read-only globals:\n";
+	for (const GlobalVariable *GV : readOnlyGlobals)
+		O << "\t" << GV->getName() << "\n";
+}
@@ -0,0 +1,99 @@
+#ifndef FUNCTION_SUMMARY_H
+#define FUNCTION_SUMMARY_H
+
+//LLVM IMPORTS
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/InstrTypes.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Operator.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/raw_ostream.h"
+
+//STL IMPORTS
+#include <map>
+#include <set>
+#include <vector>
+
+using namespace llvm;
+using namespace std;
+
+// Memory effects of a function, including the effects of everything it calls
+struct FunctionSummary
+{
+	vector<bool> argRead;
+	vector<bool> argWritten;
+	vector<bool> argCaptured;
+	set<const GlobalVariable*> readGlobals;
+	set<const GlobalVariable*> writtenGlobals;
+	// Accesses through pointers that are neither arguments, globals nor locals
+	bool readsUnknownMemory = false;
+	bool writesUnknownMemory = false;
+
+	FunctionSummary() {}
+	FunctionSummary(unsigned numArgs)
+		: argRead(numArgs, false)
+		, argWritten(numArgs, false)
+		, argCaptured(numArgs, false)
+		{}
+
+	bool operator==(const FunctionSummary &other) const
+	{
+		return argRead == other.argRead
+			&& argWritten == other.argWritten
+			&& argCaptured == other.argCaptured
+			&& readGlobals == other.readGlobals
+			&& writtenGlobals == other.writtenGlobals
+			&& readsUnknownMemory == other.readsUnknownMemory
+			&& writesUnknownMemory == other.writesUnknownMemory;
+	}
+	bool operator!=(const FunctionSummary &other) const { return !(*this == other); }
+};
+
+// Bottom-up traversal of the call graph SCCs computing a FunctionSummary for
+// every defined function. Functions of a recursive SCC are iterated until
+// their summaries are stable. Calls and invokes of functions without a summary
+// (declarations, indirect calls) fall back to the call site attributes.
+// Afterwards the globals that are never written in the module (apart from their
+// initializer) are collected. If bodies of the module were dropped before the
+// pass runs, their writes can not be seen and only constants are read-only.
+class FunctionSummaryPass : public ModulePass
+{
+private:
+	map<const Function*, FunctionSummary> summaries;
+	set<const GlobalVariable*> readOnlyGlobals;
+	bool bodiesDropped;
+
+	FunctionSummary computeSummary(Function &F);
+	void addPointerEffects(Value *ptr, unsigned argNo, FunctionSummary &S);
+	bool isOnlyRead(const Value *ptr) const;
+
+public:
+	static char ID;
+
+	FunctionSummaryPass(bool bodiesDropped = false) : ModulePass(ID), bodiesDropped(bodiesDropped) {}
+
+	bool runOnModule(Module &M) override;
+	void getAnalysisUsage(AnalysisUsage &AU) const override;
+	void print(raw_ostream &O, const Module *M) const override;
+
+	// nullptr if the function has no body in this module
+	const FunctionSummary *getSummary(const Function *F) const;
+	bool isReadOnly(const GlobalVariable *GV) const { return readOnlyGlobals.count(GV); }
+	const set<const GlobalVariable*> &getReadOnlyGlobals() const { return readOnlyGlobals; }
+
+	bool callMayReadArg(const CallBase *call, unsigned argNo) const;
+	bool callMayWriteArg(const CallBase *call, unsigned argNo) const;
+	bool callMayCaptureArg(const CallBase *call, unsigned argNo) const;
+	// Whether the call may write the object base (an alloca, global, ...).
+	// baseEscaped tells if the caller let the address of base escape.
+	bool callMayWriteObject(const CallBase *call, const Value *base, bool baseEscaped) const;
+
+	// Strips GEPs and casts to get to the object an address points into
+	static Value *getBaseObject(Value *v);
+};
+
+#endif // FUNCTION_SUMMARY_H
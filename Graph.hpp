@@ -12,9 +12,16 @@
 #include <utility>
 #include <algorithm>
 #include <iterator>
+#include <cstdint>
+#include <type_traits>
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/raw_ostream.h"
 
+template<typename NodeT, typename EdgeT, typename NodeIndexT>
+class Graph;
+
 template<typename NodeT>
 class Node
 {
@@ -22,6 +29,12 @@ private:
 	NodeT item;
 	bool highlighted;
 	std::string label;
+	// Position in Graph::nodesList
+	unsigned listPos;
+	// Index of the node in its graph, see Graph::getNodeIndex
+	int index;
+
+	template<typename, typename, typename> friend class Graph;
 public:
 	Node(NodeT _item) 
 		: item(_item)
@@ -37,6 +50,20 @@ public:
 
 };
 
+// All dependence types between two nodes, as a bitmask of edge types
+template<typename NodeT>
+struct EdgeLink
+{
+	Node<NodeT> *src;
+	Node<NodeT> *dst;
+	uint32_t types;
+	// Positions in Graph::edgesList, the out-links of src and the in-links of
+	// dst, so the link can be unlinked in constant time
+	unsigned listPos, outPos, inPos;
+};
+
+// One typed edge. Edges are views on the links of a graph and are passed by
+// value; they stay valid until their link is removed
 template<typename NodeT, typename EdgeT>
 class Edge
 {
@@ -44,43 +71,209 @@ private:
 	Node<NodeT> *src;
 	Node<NodeT> *dst;
 	EdgeT type;
+	EdgeLink<NodeT> *link;
+
+	template<typename, typename, typename> friend class Graph;
 
 public:
-	Edge(Node<NodeT> *_src, Node<NodeT> *_dst, EdgeT _type, std::string _label, bool _direction)
+	Edge(Node<NodeT> *_src, Node<NodeT> *_dst, EdgeT _type, EdgeLink<NodeT> *_link = nullptr)
 		: src(_src)
 		, dst(_dst)
 		, type(_type)
+		, link(_link)
 		{}
-	Edge(Node<NodeT> *_src, Node<NodeT> *_dst, EdgeT _type)
-		: src(_src)
-		, dst(_dst)
-		, type(_type)
-		{}
-	~Edge() {};
 
 	Node<NodeT> *getSrc() const { return src; }
 	Node<NodeT> *getDst() const { return dst; }
 	EdgeT getType() const { return type; }
-	EdgeT operator+(Edge<NodeT, EdgeT> &other)
+};
+
+// Iterates the typed edges of a list of links, optionally only the types in
+// a mask
+template<typename NodeT, typename EdgeT>
+class EdgeIterator
+{
+private:
+	typedef typename std::vector<EdgeLink<NodeT>*>::const_iterator LinkIt;
+	LinkIt it, end;
+	uint32_t mask;
+	uint32_t bits;  // types of *it that are still to be visited
+
+	void skipEmpty()
 	{
-		return this->type + other.type;
+		while (!bits && it != end)
+		{
+			++it;
+			bits = it != end ? (*it)->types & mask : 0;
+		}
 	}
+
+public:
+	typedef std::forward_iterator_tag iterator_category;
+	typedef Edge<NodeT, EdgeT> value_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef const Edge<NodeT, EdgeT> *pointer;
+	typedef Edge<NodeT, EdgeT> reference;
+
+	EdgeIterator(LinkIt _it, LinkIt _end, uint32_t _mask)
+		: it(_it)
+		, end(_end)
+		, mask(_mask)
+		, bits(_it != _end ? (*_it)->types & _mask : 0)
+		{ skipEmpty(); }
+
+	Edge<NodeT, EdgeT> operator*() const
+	{
+		return Edge<NodeT, EdgeT>((*it)->src, (*it)->dst, (EdgeT)llvm::countTrailingZeros(bits), *it);
+	}
+	EdgeIterator &operator++()
+	{
+		bits &= bits - 1;
+		skipEmpty();
+		return *this;
+	}
+	bool operator==(const EdgeIterator &other) const { return it == other.it && bits == other.bits; }
+	bool operator!=(const EdgeIterator &other) const { return !(*this == other); }
 };
 
-using namespace std;
+// The typed edges of a list of links. Invalidated by adding or removing
+// edges of the same nodes, copy it into a vector to modify the graph while
+// iterating
 template<typename NodeT, typename EdgeT>
+class EdgeRange
+{
+private:
+	const std::vector<EdgeLink<NodeT>*> *links;
+	uint32_t mask;
+
+public:
+	EdgeRange(const std::vector<EdgeLink<NodeT>*> *_links, uint32_t _mask)
+		: links(_links)
+		, mask(_mask)
+		{}
+
+	EdgeIterator<NodeT, EdgeT> begin() const { return EdgeIterator<NodeT, EdgeT>(links->begin(), links->end(), mask); }
+	EdgeIterator<NodeT, EdgeT> end() const { return EdgeIterator<NodeT, EdgeT>(links->end(), links->end(), mask); }
+	bool empty() const { return !(begin() != end()); }
+	size_t size() const
+	{
+		size_t n = 0;
+		for (EdgeLink<NodeT> *link : *links)
+			n += llvm::countPopulation(link->types & mask);
+		return n;
+	}
+	std::vector<Edge<NodeT, EdgeT>> toVector() const
+	{
+		return std::vector<Edge<NodeT, EdgeT>>(begin(), end());
+	}
+};
+
+// Node index policies: map an item to the index of its node, or -1. A policy
+// provides lookup, insert, erase and reserve.
+
+// Any ordered item type
+template<typename NodeT>
+class MapNodeIndex
+{
+private:
+	std::map<NodeT, int> indices;
+
+public:
+	int lookup(NodeT item) const
+	{
+		auto it = indices.find(item);
+		return it == indices.end() ? -1 : it->second;
+	}
+	void insert(NodeT item, int index) { indices[item] = index; }
+	void erase(NodeT item) { indices.erase(item); }
+	void reserve(size_t) {}
+};
+
+// Pointer items such as Instruction*. The pointer values must not be the
+// DenseMap empty and tombstone keys.
+template<typename NodeT>
+class DenseNodeIndex
+{
+private:
+	llvm::DenseMap<NodeT, int> indices;
+
+public:
+	int lookup(NodeT item) const
+	{
+		auto it = indices.find(item);
+		return it == indices.end() ? -1 : it->second;
+	}
+	void insert(NodeT item, int index) { indices[item] = index; }
+	void erase(NodeT item) { indices.erase(item); }
+	void reserve(size_t n) { indices.reserve(n); }
+};
+
+// Small non-negative integer items, indexed directly
+template<typename NodeT>
+class FlatNodeIndex
+{
+private:
+	std::vector<int> indices;
+
+public:
+	int lookup(NodeT item) const
+	{
+		return item >= 0 && (size_t)item < indices.size() ? indices[item] : -1;
+	}
+	void insert(NodeT item, int index)
+	{
+		if ((size_t)item >= indices.size())
+			indices.resize(std::max((size_t)item + 1, 2 * indices.size()), -1);
+		indices[item] = index;
+	}
+	void erase(NodeT item)
+	{
+		if (item >= 0 && (size_t)item < indices.size())
+			indices[item] = -1;
+	}
+	void reserve(size_t n)
+	{
+		if (n > indices.size())
+			indices.resize(n, -1);
+	}
+};
+
+template<typename NodeT>
+struct DefaultNodeIndex
+{
+	typedef typename std::conditional<std::is_pointer<NodeT>::value, DenseNodeIndex<NodeT>,
+		typename std::conditional<std::is_integral<NodeT>::value, FlatNodeIndex<NodeT>,
+			MapNodeIndex<NodeT> >::type>::type type;
+};
+
+using namespace std;
+template<typename NodeT, typename EdgeT, typename NodeIndexT = typename DefaultNodeIndex<NodeT>::type>
 class Graph
 {
 private:
 	unsigned nextIntKey = 0;
-	//This stores a map from object of type T to it's respective pair (Key, Node)
-	std::map<NodeT, std::pair<int, Node<NodeT>* > > nodes;
-	std::list<Node<NodeT>* > nodesList;
-	std::list<Edge<NodeT, EdgeT>* > edgesList;
-	//This map stores all the outcoming edges from node of type T
-	std::map<Node<NodeT>*, std::set<Edge<NodeT, EdgeT>*> > outEdges;
-	//This map stores all the incoming edges to node of type T
-	std::map<Node<NodeT>*, std::set<Edge<NodeT, EdgeT>*> > inEdges;
+	//Index of the node of each item, see getNodeIndex
+	NodeIndexT nodeIndex;
+	//Nodes by index, null once removed
+	std::vector<Node<NodeT>* > nodesByIndex;
+	std::vector<Node<NodeT>* > nodesList;
+	//One link per (src, dst) pair holding all edge types between them
+	std::vector<EdgeLink<NodeT>* > edgesList;
+	//The outcoming links of each node, by node index
+	std::vector<std::vector<EdgeLink<NodeT>*> > outEdges;
+	//The incoming links of each node, by node index
+	std::vector<std::vector<EdgeLink<NodeT>*> > inEdges;
+	const std::vector<EdgeLink<NodeT>*> noEdges;
+
+	// Removes v[pos] by moving the last element into its place; pos(e) is
+	// the position field of the element that has to follow it
+	template<typename T, typename PosF>
+	static void swapPop(std::vector<T*> &v, unsigned pos, PosF posOf)
+	{
+		v[pos] = v.back();
+		posOf(v[pos]) = pos;
+		v.pop_back();
+	}
 
 	void DFSUtil(NodeT n, NodeT search, vector<NodeT> currentPath, set<vector<NodeT>> &paths) 
 	{
@@ -91,15 +284,59 @@ private:
 			return;
 		}
 
-		for (Edge<NodeT, EdgeT> *e : getOutEdges(n)){
-			NodeT dst = e->getDst()->getItem();
+		for (Edge<NodeT, EdgeT> e : getOutEdges(n)){
+			NodeT dst = e.getDst()->getItem();
 			if(find(currentPath.begin(), currentPath.end(), dst) == currentPath.end()){
 				DFSUtil(dst, search, currentPath, paths);
 			}
 		}
 	}
 
+	EdgeLink<NodeT> *findLink(Node<NodeT> *src, Node<NodeT> *dst) const
+	{
+		for (EdgeLink<NodeT> *link : getOutLinks(src))
+		{
+			if (link->dst == dst)
+				return link;
+		}
+		return nullptr;
+	}
+
+	const std::vector<EdgeLink<NodeT>*> &getOutLinks(Node<NodeT> *node) const
+	{
+		return node ? outEdges[node->index] : noEdges;
+	}
+
+	const std::vector<EdgeLink<NodeT>*> &getInLinks(Node<NodeT> *node) const
+	{
+		return node ? inEdges[node->index] : noEdges;
+	}
+
+	Node<NodeT> *createNode(NodeT item)
+	{
+		Node<NodeT> *node = new Node<NodeT>(item);
+		node->index = nextIntKey;
+		nodesByIndex.push_back(node);
+		outEdges.emplace_back();
+		inEdges.emplace_back();
+		node->listPos = nodesList.size();
+		nodesList.push_back(node);
+		nextIntKey++;
+		return node;
+	}
+
+	void removeLink(EdgeLink<NodeT> *link)
+	{
+		swapPop(outEdges[link->src->index], link->outPos, [](EdgeLink<NodeT> *x) -> unsigned& { return x->outPos; });
+		swapPop(inEdges[link->dst->index], link->inPos, [](EdgeLink<NodeT> *x) -> unsigned& { return x->inPos; });
+		swapPop(edgesList, link->listPos, [](EdgeLink<NodeT> *x) -> unsigned& { return x->listPos; });
+		delete link;
+	}
+
 public:
+	static const uint32_t ALL_TYPES = ~0u;
+	static uint32_t typeMask(EdgeT type) { return 1u << type; }
+
 	Graph() {};
 	~Graph()
 	{
@@ -109,81 +346,100 @@ public:
 
 	Node<NodeT> *operator[](NodeT item) const { return getNode(item); }
 
+	// Makes room for n nodes, e.g. the instruction count of a function
+	void reserveNodes(size_t n)
+	{
+		nodeIndex.reserve(n);
+		nodesByIndex.reserve(n);
+		nodesList.reserve(n);
+		outEdges.reserve(n);
+		inEdges.reserve(n);
+	}
+
 	Node<NodeT> *addNode(NodeT item)
 	{
-		if (nodes.count(item) == 0)
+		int index = nodeIndex.lookup(item);
+		if (index == -1)
 		{
-			Node<NodeT> *node = new Node<NodeT>(item);
-			nodes[item] = std::make_pair<int,  Node<NodeT>* >(nextIntKey, std::move(node));
-			nodesList.push_back(node);
-			nextIntKey++;
-			return node;
+			nodeIndex.insert(item, nextIntKey);
+			return createNode(item);
 		}
 		else
 		{
 			#ifdef DEBUG_GRAPH_HPP
 				std::cout << "\nTrying to add an already added item.\n";
 			#endif
-			return nodes.find(item)->second.second;
+			return nodesByIndex[index];
 		}
 	}
 
+	// Adds a node without an item, e.g. an entry or exit node. Item lookups
+	// never find it, it is only reachable by pointer, index and edges
+	Node<NodeT> *addVirtualNode()
+	{
+		return createNode(NodeT());
+	}
+
 	Node<NodeT> *getNode(NodeT item)
 	{
-		if (nodes.count(item) == 0)
+		int index = nodeIndex.lookup(item);
+		if (index == -1)
 			return addNode(item);
-		return nodes.find(item)->second.second;
+		return nodesByIndex[index];
 	}
 
 	Node<NodeT> *getNodeByIndex(const int index) const
 	{
-		for (const auto &pair_ : nodes)
-		{
-			if (pair_.second.first == index)
-			{
-				return pair_.second.second;
-			}
-		}
-		return nullptr;	
+		if (index < 0 || index >= (int)nodesByIndex.size())
+			return nullptr;
+		return nodesByIndex[index];
 	}
 
 	int getNodeIndex(NodeT item) const
 	{
-		if (nodes.count(item) == 0)
-			return -1;
-		return nodes.find(item)->second.first;
+		return nodeIndex.lookup(item);
 	}
 
 	int getNodeIndex(Node<NodeT> *node) const
 	{
-		for (auto &n : nodes)
-		{
-			if (n.second.second == node)
-				return n.second.first;
-		}
-		return -1;
+		return node ? node->index : -1;
 	}
 
-	std::list< Node<NodeT>*> getNodes() const
+	const std::vector< Node<NodeT>*> &getNodes() const
 	{
 		return nodesList;
 	}
 
-	Edge<NodeT, EdgeT> *addEdge(Node<NodeT> *src, Node<NodeT> *dst, EdgeT e)
+	// Returns false if the edge already exists
+	bool addEdge(Node<NodeT> *src, Node<NodeT> *dst, EdgeT e)
 	{
-		for(Edge<NodeT, EdgeT> *ed : outEdges[src]){
-			if(ed->getDst() == dst && ed->getType() == e){
-				return nullptr;
-			}
+		EdgeLink<NodeT> *link = findLink(src, dst);
+		if (link)
+		{
+			if (link->types & typeMask(e))
+				return false;
+			link->types |= typeMask(e);
+			return true;
 		}
-		Edge<NodeT, EdgeT> *edge = new Edge<NodeT, EdgeT>(src, dst, e);
-		outEdges[src].insert(edge);
-		inEdges[dst].insert(edge);
-		edgesList.push_back(edge);
-		return edge;
+		link = new EdgeLink<NodeT>{src, dst, typeMask(e), 0, 0, 0};
+		std::vector<EdgeLink<NodeT>*> &out = outEdges[src->index];
+		std::vector<EdgeLink<NodeT>*> &in = inEdges[dst->index];
+		link->outPos = out.size();
+		out.push_back(link);
+		link->inPos = in.size();
+		in.push_back(link);
+		link->listPos = edgesList.size();
+		edgesList.push_back(link);
+		return true;
 	}
 
-	Edge<NodeT, EdgeT> *addEdge(NodeT src, NodeT dst, EdgeT e)
+	bool hasEdge(Node<NodeT> *src, Node<NodeT> *dst, EdgeT e) const
+	{
+		EdgeLink<NodeT> *link = findLink(src, dst);
+		return link && (link->types & typeMask(e));
+	}
+
+	bool addEdge(NodeT src, NodeT dst, EdgeT e)
 	{
 		Node<NodeT> *src_ = getNode(src);
 		Node<NodeT> *dst_ = getNode(dst);
@@ -191,50 +447,67 @@ public:
 		return addEdge(src_, dst_, e);
 	}
 
-	std::set<Edge<NodeT, EdgeT>*> getInEdges(Node<NodeT> *node) 
+	// Typed edges, optionally only those whose type is in mask (see typeMask)
+	EdgeRange<NodeT, EdgeT> getInEdges(Node<NodeT> *node, uint32_t mask = ALL_TYPES) const
 	{
-		std::set<Edge<NodeT, EdgeT>*> inEdges_;
-		if (inEdges.find(node) != inEdges.end())
-			inEdges_ = inEdges[node];
-		
-		return inEdges_;
+		return EdgeRange<NodeT, EdgeT>(&getInLinks(node), mask);
 	}
 
-	std::set<Edge<NodeT, EdgeT>*> getInEdges(NodeT item)
+	EdgeRange<NodeT, EdgeT> getInEdges(NodeT item, uint32_t mask = ALL_TYPES)
 	{
 		Node<NodeT> *node = getNode(item);
 		
-		return getInEdges(node);
+		return getInEdges(node, mask);
 	}
 
-	std::set<Edge<NodeT, EdgeT>*> getOutEdges(Node<NodeT> *node) 
+	EdgeRange<NodeT, EdgeT> getOutEdges(Node<NodeT> *node, uint32_t mask = ALL_TYPES) const
 	{
-		std::set<Edge<NodeT, EdgeT>*> outEdges_;
-		if (outEdges.count(node) != 0)
-			return outEdges[node];
-		return outEdges_;
+		return EdgeRange<NodeT, EdgeT>(&getOutLinks(node), mask);
 	}
 
-	std::set<Edge<NodeT, EdgeT>*> getOutEdges(NodeT item)
+	EdgeRange<NodeT, EdgeT> getOutEdges(NodeT item, uint32_t mask = ALL_TYPES)
 	{	
-		return getOutEdges(getNode(item));
+		return getOutEdges(getNode(item), mask);
 	}
 
-	void removeEdge(Edge<NodeT, EdgeT>* e)
+	EdgeRange<NodeT, EdgeT> getEdges(uint32_t mask = ALL_TYPES) const
 	{
-		auto out = e->getSrc();
-		auto in = e->getDst();
-		edgesList.remove(e);
-		outEdges[out].erase(e);
-		inEdges[in].erase(e);
+		return EdgeRange<NodeT, EdgeT>(&edgesList, mask);
+	}
+
+	// Removes one type from its link, and the link once it has no type left
+	void removeEdge(const Edge<NodeT, EdgeT> &e)
+	{
+		EdgeLink<NodeT> *link = e.link ? e.link : findLink(e.getSrc(), e.getDst());
+		if (!link)
+			return;
+		link->types &= ~typeMask(e.getType());
+		if (!link->types)
+			removeLink(link);
 	}
 
-	std::list<Edge<NodeT, EdgeT>* > getEdges() const
+	// Removes and deletes the node and all its incident edges
+	void removeNode(Node<NodeT> *node)
 	{
-		return edgesList;
+		std::vector<EdgeLink<NodeT>*> &out = outEdges[node->index];
+		while (!out.empty())
+			removeLink(out.back());
+		std::vector<EdgeLink<NodeT>*>().swap(out);
+		std::vector<EdgeLink<NodeT>*> &in = inEdges[node->index];
+		while (!in.empty())
+			removeLink(in.back());
+		std::vector<EdgeLink<NodeT>*>().swap(in);
+		if (nodeIndex.lookup(node->getItem()) == node->index)
+			nodeIndex.erase(node->getItem());
+		nodesByIndex[node->index] = nullptr;
+		swapPop(nodesList, node->listPos, [](Node<NodeT> *x) -> unsigned& { return x->listPos; });
+		delete node;
 	}
 
-	int size() const { return nextIntKey; }
+	// Number of live nodes
+	int size() const { return nodesList.size(); }
+	// Indices handed out so far, including those of removed nodes
+	int getNumNodeIndices() const { return nextIntKey; }
 
 	set<vector<NodeT>> getPaths(Node<NodeT>* start, Node<NodeT>* end){
 		return getPaths(start->getItem(), end->getItem());
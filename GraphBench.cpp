@@ -0,0 +1,396 @@
+//===- GraphBench.cpp - Microbenchmarks for Graph.hpp ---------------------===//
+//
+// Measures the basic operations of Graph<NodeT, EdgeT, NodeIndexT> on graphs
+// of 10^3 to 10^6 nodes. Follows the Google Benchmark model: every benchmark runs its
+// timed loop with an increasing number of iterations until -benchMinTime is
+// reached, setup can be excluded with pauseTiming()/resumeTiming(), and the
+// time per iteration and per processed item are reported.
+//
+// The graphs have the shape of a dependence graph: a CTR chain through all
+// nodes and one data dependence per node to a pseudo-random node.
+//
+// Operations whose cost depends on the graph size (getNodeIndex(Node*),
+// removeEdge) are measured on a fixed batch per iteration, so their per-item
+// time shows the scaling directly.
+//
+// Every benchmark runs on int graphs with each node index policy and on
+// Instruction* graphs, the ones the analysis builds, with DenseNodeIndex and
+// MapNodeIndex (FlatNodeIndex needs integral items). The unsuffixed names
+// are int graphs with FlatNodeIndex.
+//
+//===----------------------------------------------------------------------===//
+
+//LOCAL IMPORTS
+#include "EdgeDepType.h"
+#include "Graph.hpp"
+
+//LLVM IMPORTS
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/Regex.h"
+#include "llvm/Support/raw_ostream.h"
+
+//STL IMPORTS
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+static cl::opt<std::string> benchFilter("benchFilter", cl::desc("Only run the benchmarks whose name matches this regex"), cl::init(".*"), cl::value_desc("regex"));
+static cl::opt<double> benchMinTime("benchMinTime", cl::desc("Minimum measured seconds per benchmark and size"), cl::init(0.5));
+static cl::opt<unsigned> benchMaxNodes("benchMaxNodes", cl::desc("Largest graph size"), cl::init(1000000));
+
+// Lookups and removals per iteration for the size-dependent operations
+static const int BATCH = 1000;
+
+class BenchState
+{
+	typedef std::chrono::steady_clock clock;
+
+	uint64_t iterations = 0;
+	uint64_t maxIterations;
+	uint64_t items = 0;
+	double elapsed = 0;
+	bool running = false;
+	clock::time_point start;
+
+public:
+	const int range;
+
+	BenchState(int range, uint64_t maxIterations) : maxIterations(maxIterations), range(range) {}
+
+	// Starts the timer on the first call, stops it after the last iteration
+	bool keepRunning()
+	{
+		if (iterations == 0)
+			resumeTiming();
+		if (iterations++ < maxIterations)
+			return true;
+		pauseTiming();
+		--iterations;
+		return false;
+	}
+
+	void pauseTiming()
+	{
+		if (!running)
+			return;
+		elapsed += std::chrono::duration<double>(clock::now() - start).count();
+		running = false;
+	}
+
+	void resumeTiming()
+	{
+		if (running)
+			return;
+		start = clock::now();
+		running = true;
+	}
+
+	void addItemsProcessed(uint64_t n) { items += n; }
+
+	uint64_t getIterations() const { return iterations; }
+	uint64_t getItemsProcessed() const { return items; }
+	double getElapsed() const { return elapsed; }
+};
+
+struct Benchmark
+{
+	std::string name;
+	std::function<void(BenchState&)> fn;
+};
+
+// Real instructions as graph items, so that the pointer values and their
+// hashing match the graphs of the analysis
+class InstructionItems
+{
+private:
+	LLVMContext context;
+	std::unique_ptr<Module> module;
+	BasicBlock *block;
+	std::vector<Instruction*> items;
+
+public:
+	InstructionItems() : module(new Module("graph-bench", context))
+	{
+		Function *F = Function::Create(FunctionType::get(Type::getVoidTy(context), false),
+		                               GlobalValue::ExternalLinkage, "f", module.get());
+		block = BasicBlock::Create(context, "entry", F);
+	}
+
+	Instruction *get(int i)
+	{
+		while ((int)items.size() <= i)
+			items.push_back(new AllocaInst(Type::getInt32Ty(context), 0, "", block));
+		return items[i];
+	}
+};
+
+template<typename NodeT> struct BenchItem;
+
+template<> struct BenchItem<int>
+{
+	static int get(int i) { return i; }
+};
+
+template<> struct BenchItem<Instruction*>
+{
+	static Instruction *get(int i)
+	{
+		static InstructionItems items;
+		return items.get(i);
+	}
+};
+
+// The items of the nodes 0..n-1, created outside of the timed regions
+template<typename NodeT>
+static std::vector<NodeT> getItems(int n)
+{
+	std::vector<NodeT> items;
+	items.reserve(n);
+	for (int i = 0; i < n; ++i)
+		items.push_back(BenchItem<NodeT>::get(i));
+	return items;
+}
+
+// Node i has a CTR edge to i+1 and a RAW edge to a pseudo-random node
+template<typename GraphT, typename NodeT>
+static void buildGraph(GraphT &G, const std::vector<NodeT> &items)
+{
+	int n = items.size();
+	for (int i = 0; i < n; ++i)
+		G.addNode(items[i]);
+	for (int i = 0; i + 1 < n; ++i)
+		G.addEdge(items[i], items[i + 1], EdgeDepType::CTR);
+	for (int i = 0; i < n; ++i)
+		G.addEdge(items[i], items[(i * 7919LL + 13) % n], EdgeDepType::RAW);
+}
+
+template<typename NodeT, typename IndexT>
+static void BM_AddNode(BenchState &state)
+{
+	typedef Graph<NodeT, EdgeDepType, IndexT> GraphT;
+	std::vector<NodeT> items = getItems<NodeT>(state.range);
+	while (state.keepRunning())
+	{
+		state.pauseTiming();
+		GraphT *G = new GraphT();
+		state.resumeTiming();
+		for (int i = 0; i < state.range; ++i)
+			G->addNode(items[i]);
+		state.pauseTiming();
+		delete G;
+		state.resumeTiming();
+		state.addItemsProcessed(state.range);
+	}
+}
+
+template<typename NodeT, typename IndexT>
+static void BM_AddEdge(BenchState &state)
+{
+	typedef Graph<NodeT, EdgeDepType, IndexT> GraphT;
+	std::vector<NodeT> items = getItems<NodeT>(state.range);
+	while (state.keepRunning())
+	{
+		state.pauseTiming();
+		GraphT *G = new GraphT();
+		for (int i = 0; i < state.range; ++i)
+			G->addNode(items[i]);
+		state.resumeTiming();
+		for (int i = 0; i + 1 < state.range; ++i)
+			G->addEdge(items[i], items[i + 1], EdgeDepType::CTR);
+		for (int i = 0; i < state.range; ++i)
+			G->addEdge(items[i], items[(i * 7919LL + 13) % state.range], EdgeDepType::RAW);
+		state.pauseTiming();
+		delete G;
+		state.resumeTiming();
+		state.addItemsProcessed(2 * state.range - 1);
+	}
+}
+
+template<typename NodeT, typename IndexT>
+static void BM_OutEdges(BenchState &state)
+{
+	Graph<NodeT, EdgeDepType, IndexT> G;
+	buildGraph(G, getItems<NodeT>(state.range));
+	const std::vector<Node<NodeT>*> &nodes = G.getNodes();
+	long sum = 0;
+	while (state.keepRunning())
+	{
+		for (Node<NodeT> *n : nodes)
+			for (Edge<NodeT, EdgeDepType> e : G.getOutEdges(n))
+				sum += e.getType();
+		state.addItemsProcessed(nodes.size());
+	}
+	if (sum == 42)
+		outs() << "";
+}
+
+template<typename NodeT, typename IndexT>
+static void BM_InEdges(BenchState &state)
+{
+	Graph<NodeT, EdgeDepType, IndexT> G;
+	buildGraph(G, getItems<NodeT>(state.range));
+	const std::vector<Node<NodeT>*> &nodes = G.getNodes();
+	long sum = 0;
+	while (state.keepRunning())
+	{
+		for (Node<NodeT> *n : nodes)
+			for (Edge<NodeT, EdgeDepType> e : G.getInEdges(n))
+				sum += e.getType();
+		state.addItemsProcessed(nodes.size());
+	}
+	if (sum == 42)
+		outs() << "";
+}
+
+template<typename NodeT, typename IndexT>
+static void BM_NodeIndexByItem(BenchState &state)
+{
+	Graph<NodeT, EdgeDepType, IndexT> G;
+	std::vector<NodeT> items = getItems<NodeT>(state.range);
+	buildGraph(G, items);
+	long sum = 0;
+	while (state.keepRunning())
+	{
+		for (int i = 0; i < state.range; ++i)
+			sum += G.getNodeIndex(items[i]);
+		state.addItemsProcessed(state.range);
+	}
+	if (sum == 42)
+		outs() << "";
+}
+
+template<typename NodeT, typename IndexT>
+static void BM_NodeIndexByNode(BenchState &state)
+{
+	Graph<NodeT, EdgeDepType, IndexT> G;
+	buildGraph(G, getItems<NodeT>(state.range));
+	const std::vector<Node<NodeT>*> &nodes = G.getNodes();
+	long sum = 0;
+	while (state.keepRunning())
+	{
+		for (int i = 0; i < BATCH; ++i)
+			sum += G.getNodeIndex(nodes[(i * 7919LL) % nodes.size()]);
+		state.addItemsProcessed(BATCH);
+	}
+	if (sum == 42)
+		outs() << "";
+}
+
+template<typename NodeT, typename IndexT>
+static void BM_RemoveEdge(BenchState &state)
+{
+	typedef Graph<NodeT, EdgeDepType, IndexT> GraphT;
+	std::vector<NodeT> items = getItems<NodeT>(state.range);
+	while (state.keepRunning())
+	{
+		state.pauseTiming();
+		GraphT *G = new GraphT();
+		buildGraph(*G, items);
+		std::vector<Edge<NodeT, EdgeDepType>> edges;
+		for (Edge<NodeT, EdgeDepType> e : G->getEdges(GraphT::typeMask(EdgeDepType::RAW)))
+			if ((int)edges.size() < BATCH)
+				edges.push_back(e);
+		state.resumeTiming();
+		for (Edge<NodeT, EdgeDepType> &e : edges)
+			G->removeEdge(e);
+		state.pauseTiming();
+		delete G;
+		state.resumeTiming();
+		state.addItemsProcessed(edges.size());
+	}
+}
+
+template<typename NodeT, typename IndexT>
+static void BM_Destroy(BenchState &state)
+{
+	typedef Graph<NodeT, EdgeDepType, IndexT> GraphT;
+	std::vector<NodeT> items = getItems<NodeT>(state.range);
+	while (state.keepRunning())
+	{
+		state.pauseTiming();
+		GraphT *G = new GraphT();
+		buildGraph(*G, items);
+		state.resumeTiming();
+		delete G;
+		state.addItemsProcessed(state.range);
+	}
+}
+
+template<typename NodeT, typename IndexT>
+static void addBenchmarks(std::vector<Benchmark> &benchmarks, const std::string &suffix)
+{
+	benchmarks.push_back({"BM_AddNode" + suffix, BM_AddNode<NodeT, IndexT>});
+	benchmarks.push_back({"BM_AddEdge" + suffix, BM_AddEdge<NodeT, IndexT>});
+	benchmarks.push_back({"BM_OutEdges" + suffix, BM_OutEdges<NodeT, IndexT>});
+	benchmarks.push_back({"BM_InEdges" + suffix, BM_InEdges<NodeT, IndexT>});
+	benchmarks.push_back({"BM_NodeIndexByItem" + suffix, BM_NodeIndexByItem<NodeT, IndexT>});
+	benchmarks.push_back({"BM_NodeIndexByNode" + suffix, BM_NodeIndexByNode<NodeT, IndexT>});
+	benchmarks.push_back({"BM_RemoveEdge" + suffix, BM_RemoveEdge<NodeT, IndexT>});
+	benchmarks.push_back({"BM_Destroy" + suffix, BM_Destroy<NodeT, IndexT>});
+}
+
+// Runs the benchmark with more iterations until it takes -benchMinTime
+static void runBenchmark(const Benchmark &bm, int range)
+{
+	uint64_t iterations = 1;
+	while (true)
+	{
+		BenchState state(range, iterations);
+		bm.fn(state);
+		double t = state.getElapsed();
+		if (t >= benchMinTime || iterations >= (1ull << 30))
+		{
+			std::string name = bm.name + "/" + std::to_string(range);
+			outs() << format("%-40s %14.0f ns %10llu %14.1f ns/item\n", name.c_str(),
+			                 t * 1e9 / state.getIterations(), (unsigned long long)state.getIterations(),
+			                 state.getItemsProcessed() ? t * 1e9 / state.getItemsProcessed() : 0.0);
+			outs().flush();
+			return;
+		}
+		// Aim a bit beyond the minimum time, like Google Benchmark
+		double factor = t > 0 ? benchMinTime * 1.4 / t : 10;
+		iterations = std::max(iterations + 1, (uint64_t)(iterations * std::min(factor, 10.0)));
+	}
+}
+
+int main(int argc, char **argv)
+{
+	InitLLVM X(argc, argv);
+	cl::ParseCommandLineOptions(argc, argv, "Graph.hpp microbenchmarks\n");
+
+	std::vector<Benchmark> benchmarks;
+	addBenchmarks<int, FlatNodeIndex<int> >(benchmarks, "");
+	addBenchmarks<int, DenseNodeIndex<int> >(benchmarks, "<int,Dense>");
+	addBenchmarks<int, MapNodeIndex<int> >(benchmarks, "<int,Map>");
+	addBenchmarks<Instruction*, DenseNodeIndex<Instruction*> >(benchmarks, "<Inst,Dense>");
+	addBenchmarks<Instruction*, MapNodeIndex<Instruction*> >(benchmarks, "<Inst,Map>");
+
+	Regex filter(benchFilter);
+	std::string error;
+	if (!filter.isValid(error))
+	{
+		errs() << "Invalid -benchFilter: " << error << "\n";
+		return 1;
+	}
+
+	outs() << format("%-40s %17s %10s %23s\n", (const char*)"Benchmark", (const char*)"Time", (const char*)"Iterations", (const char*)"Per item");
+	for (const Benchmark &bm : benchmarks)
+	{
+		if (!filter.match(bm.name))
+			continue;
+		for (int range = 1000; range <= (int)benchMaxNodes; range *= 10)
+			runBenchmark(bm, range);
+	}
+	return 0;
+}
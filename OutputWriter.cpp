@@ -0,0 +1,122 @@
+//LOCAL IMPORTS
+#include "OutputWriter.h"
+
+//LLVM IMPORTS
+#include "llvm/Support/Threading.h"
+
+OutputWriter::OutputWriter(unsigned maxQueued)
+	: maxQueued(llvm_is_multithreaded() ? maxQueued : 0)
+{
+	if (this->maxQueued)
+		thread = std::thread([this] { run(); });
+}
+
+OutputWriter::~OutputWriter()
+{
+	flush();
+	if (thread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		queued.notify_all();
+		thread.join();
+	}
+}
+
+bool OutputWriter::writeFile(const std::string &path, const RenderFn &render, uint64_t &size, std::string &error)
+{
+	std::error_code EC;
+	raw_fd_ostream stream(path, EC);
+	if (EC)
+	{
+		error = "Problem opening file: " + path + " (" + EC.message() + ")";
+		return false;
+	}
+	render(stream);
+	size = stream.tell();
+	stream.close();
+	if (stream.has_error())
+	{
+		stream.clear_error();
+		error = "Problem writing file: " + path;
+		return false;
+	}
+	return true;
+}
+
+void OutputWriter::write(const Job &job)
+{
+	uint64_t size = 0;
+	std::string error;
+	bool ok = writeFile(job.path, job.render, size, error);
+	std::lock_guard<std::mutex> lock(mutex);
+	if (ok)
+		bytes[job.key] += size;
+	else
+		errors.push_back(error);
+}
+
+void OutputWriter::run()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true)
+	{
+		queued.wait(lock, [this] { return stopping || !queue.empty(); });
+		if (queue.empty())
+			return;
+		Job job = std::move(queue.front());
+		queue.pop_front();
+		writing = true;
+		dequeued.notify_all();
+		lock.unlock();
+		write(job);
+		lock.lock();
+		writing = false;
+		dequeued.notify_all();
+	}
+}
+
+void OutputWriter::submit(std::string key, std::string path, RenderFn render)
+{
+	if (!maxQueued)
+	{
+		write(Job{std::move(key), std::move(path), std::move(render)});
+		return;
+	}
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		dequeued.wait(lock, [this] { return queue.size() < maxQueued; });
+		queue.push_back(Job{std::move(key), std::move(path), std::move(render)});
+	}
+	queued.notify_one();
+}
+
+void OutputWriter::flush()
+{
+	std::vector<std::string> pending;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		dequeued.wait(lock, [this] { return queue.empty() && !writing; });
+		pending.swap(errors);
+	}
+	for (const std::string &error : pending)
+		errs() << error << "\n";
+}
+
+uint64_t OutputWriter::getBytes(const std::string &key)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = bytes.find(key);
+	return it == bytes.end() ? 0 : it->second;
+}
+
+uint64_t OutputWriter::getTotalBytes()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	uint64_t total = 0;
+	for (auto &pair : bytes)
+		total += pair.second;
+	return total;
+}
@@ -0,0 +1,73 @@
+#ifndef OUTPUT_WRITER_H
+#define OUTPUT_WRITER_H
+
+//LLVM IMPORTS
+#include "llvm/Support/raw_ostream.h"
+
+//STL IMPORTS
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace llvm;
+
+// Writes the graphs and reports on a background thread, so the analysis of
+// the next function overlaps with rendering and I/O. A job renders its file
+// from data it owns (e.g. a PDGSnapshot), never from the IR, which may
+// change once the pass returns.
+//
+// At most maxQueued jobs wait for the thread, submit() blocks beyond that.
+// With maxQueued == 0, or without thread support, jobs are written
+// synchronously by submit().
+class OutputWriter
+{
+public:
+	typedef std::function<void(raw_ostream&)> RenderFn;
+
+private:
+	struct Job
+	{
+		std::string key;
+		std::string path;
+		RenderFn render;
+	};
+
+	unsigned maxQueued;
+	std::deque<Job> queue;
+	bool writing = false;
+	bool stopping = false;
+	std::mutex mutex;
+	std::condition_variable queued;
+	std::condition_variable dequeued;
+	std::thread thread;
+	// Written bytes per key and errors, reported on the submitting thread
+	std::map<std::string, uint64_t> bytes;
+	std::vector<std::string> errors;
+
+	void run();
+	void write(const Job &job);
+
+public:
+	OutputWriter(unsigned maxQueued);
+	// Writes the remaining jobs
+	~OutputWriter();
+
+	// Renders path on the background thread; the bytes are added to key
+	void submit(std::string key, std::string path, RenderFn render);
+	// Waits until all submitted files are written and prints their errors
+	void flush();
+	// Bytes written for key, complete after flush()
+	uint64_t getBytes(const std::string &key);
+	uint64_t getTotalBytes();
+
+	// Writes one file on the calling thread. Returns false and sets error if
+	// it can't be opened or written
+	static bool writeFile(const std::string &path, const RenderFn &render, uint64_t &size, std::string &error);
+};
+
+#endif // OUTPUT_WRITER_H
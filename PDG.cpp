@@ -1,7 +1,10 @@
 //LOCAL IMPORTS
 #include "PDG.h"
+#include "PDGBinary.h"
+#include "OutputWriter.h"
 
 //LLVM IMPORTS
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/raw_ostream.h"
 
 
@@ -13,6 +16,15 @@
 
 static cl::opt<bool, false> removeTransitiveDeps("removeTransitiveDeps", cl::desc("Remove transitive dependencies"), cl::NotHidden);
 static cl::opt<string> fmap("fmap", cl::desc("DP-FileMapping filename"), cl::value_desc("filename"));
+static cl::opt<string> depOutputDir("depOutputDir", cl::desc("Directory the graphs and reports are written to"), cl::value_desc("directory"));
+
+std::string PDG::outputPath(std::string fileName)
+{
+	if (depOutputDir.empty())
+		return fileName;
+	sys::fs::create_directories(depOutputDir);
+	return depOutputDir + "/" + fileName;
+}
 
 string PDG::nodeLabel(Instruction *inst){
 	std::function<std::string(Instruction*)> getVarName;
@@ -81,12 +93,14 @@ string PDG::nodeLabel(Instruction *inst){
 	return "?";
 }
 
-string PDG::edgeLabel(Edge<Instruction*, EdgeDepType> *e)
+string PDG::edgeLabel(const Edge<Instruction*, EdgeDepType> &e)
 {
-	switch (e->getType())
+	switch (e.getType())
 	{
 		case EdgeDepType::RAR: return "RAR";
 		case EdgeDepType::RAWLC: return "RAW*";
+		case EdgeDepType::WARLC: return "WAR*";
+		case EdgeDepType::WAWLC: return "WAW*";
 		case EdgeDepType::WAW: return "WAW";
 		case EdgeDepType::RAW: return "RAW";
 		case EdgeDepType::WAR: return "WAR";
@@ -94,125 +108,261 @@ string PDG::edgeLabel(Edge<Instruction*, EdgeDepType> *e)
 		case EdgeDepType::PARENT: return "PARENT";
 		case EdgeDepType::SCA:
 		{
-			if (e->getSrc()->getItem()->hasName())
-				return e->getSrc()->getItem()->getName();
+			if (e.getSrc()->getItem()->hasName())
+				return e.getSrc()->getItem()->getName();
 			else
 				return "SCA";
 		}
-		default: return std::to_string(e->getType());
+		default: return std::to_string(e.getType());
 	}
 }
 
-void PDG::dumpToDot(){
-	std::string graphName = functionName + ".dot";
-	this->dumpToDot(graphName);
-}
-
-void PDG::dumpToDot(std::string graphName)
+std::shared_ptr<const PDGSnapshot> PDG::snapshot()
 {
-	
-	// Write the graph to a DOT file
-	ofstream dotStream;
-	dotStream.open(graphName);
-	if (!dotStream.is_open())
+	std::shared_ptr<PDGSnapshot> snap = std::make_shared<PDGSnapshot>();
+	snap->nodes.reserve(getNumNodeIndices());
+	for (int i = 0; i < getNumNodeIndices(); ++i)
 	{
-		errs() << "Problem opening DOT file: " << graphName << "\n";
-	}	
-	else
+		PDGSnapshot::NodeInfo n;
+		n.index = i;
+		n.kind = PDG_NODE_OTHER;
+		n.highlighted = false;
+		n.isolated = true;
+		n.hasDebugLoc = false;
+		n.line = 0;
+		n.col = 0;
+		Node<Instruction*> *node = getNodeByIndex(i);
+		if (node == nullptr)
+		{
+			n.kind = PDG_NODE_REMOVED;
+			snap->nodes.push_back(std::move(n));
+			continue;
+		}
+		n.highlighted = node->isHighlighted();
+		n.isolated = getInEdges(node).empty() && getOutEdges(node).empty();
+		if (isEntry(node))
+			n.kind = PDG_NODE_ENTRY;
+		else if (isExit(node))
+			n.kind = PDG_NODE_EXIT;
+		else if (Instruction *I = node->getItem())
+		{
+			if (isa<StoreInst>(I) || isa<LoadInst>(I))
+			{
+				n.kind = isa<StoreInst>(I) ? PDG_NODE_WRITE : PDG_NODE_READ;
+				n.var = I->getOperand(isa<StoreInst>(I) ? 1 : 0)->getName().str();
+				n.label = nodeLabel(I);
+			}
+			else if (DbgDeclareInst* DbgDeclare = dyn_cast<DbgDeclareInst>(I))
+			{
+				n.kind = PDG_NODE_DECLARE;
+				n.var = DbgDeclare->getAddress()->getName().str();
+			}
+			if (DebugLoc dl = I->getDebugLoc())
+			{
+				n.hasDebugLoc = true;
+				n.line = dl.getLine();
+				n.col = dl.getCol();
+				n.file = cast<DIScope>(dl.getScope())->getFilename().str();
+			}
+		}
+		snap->nodes.push_back(std::move(n));
+	}
+
+	snap->edges.reserve(getEdges().size());
+	for (auto e : getEdges())
 	{
-		dotStream << "digraph g {\n";
+		PDGSnapshot::EdgeInfo edge;
+		edge.src = getNodeIndex(e.getSrc());
+		edge.dst = getNodeIndex(e.getDst());
+		edge.type = e.getType();
+		edge.sameVar = false;
+		if (e.getType() == EdgeDepType::RAW || e.getType() == EdgeDepType::WAR || e.getType() == EdgeDepType::WAW)
+		{
+			std::string srcName = e.getSrc()->getItem()->getOperand(isa<StoreInst>(e.getSrc()->getItem()) ? 1 : 0)->getName().str();
+			std::string dstName = e.getDst()->getItem()->getOperand(isa<StoreInst>(e.getDst()->getItem()) ? 1 : 0)->getName().str();
+			edge.sameVar = srcName == dstName;
+		}
+		else if (e.getType() != EdgeDepType::CTR)
+		{
+			edge.label = edgeLabel(e);
+		}
+		snap->edges.push_back(std::move(edge));
+	}
+	return snap;
+}
+
+void PDGSnapshot::renderDot(raw_ostream &dotStream) const
+{
+	dotStream << "digraph g {\n";
 
-		// Create all nodes in DOT format
-		for (auto node : getNodes())
+	// Create all nodes in DOT format
+	for (const NodeInfo &node : nodes)
+	{
+		if (node.kind == PDG_NODE_ENTRY)
+			dotStream << "\t\"" << node.index << "\" [label=entry];\n";
+		else if (node.kind == PDG_NODE_EXIT)
+			dotStream << "\t\"" << node.index << "\" [label=exit];\n";
+		else if (!node.hasDebugLoc)
+			continue;
+		else if (node.kind == PDG_NODE_READ || node.kind == PDG_NODE_WRITE)
 		{
-			if (node == this->entry)
-				dotStream << "\t\"" << getNodeIndex(node) << "\" [label=entry];\n";
-			else if (node == this->exit)
-				dotStream << "\t\"" << getNodeIndex(node) << "\" [label=exit];\n";
-			else if (node->getItem()){
-				DebugLoc dl = node->getItem()->getDebugLoc();
-				if(!dl) continue;
-				Instruction *I = node->getItem();
-				if(isa<StoreInst>(I) || isa<LoadInst>(I)){
-					dotStream << "\t\"" << 
-					getNodeIndex(node) 
-					<< "\" [label=\"" << nodeLabel(node->getItem()) << "\"" 
-					<< (node->isHighlighted() ? ",style=filled,fillcolor=red": "")
-					<< "];\n";
-				}else if(DbgDeclareInst* DbgDeclare = dyn_cast<DbgDeclareInst>(I)){
-					dotStream << "\t\"" << 
-					getNodeIndex(node) 
-					<< "\" [label=\"" << getNodeIndex(node) << "\\n"
-					<< "declare(" << DbgDeclare->getAddress()->getName().str() << "): "
-					<<  (dl ? to_string(dl.getLine()) : "") << (dl ? "," : "") << (dl ? to_string(dl.getCol()) : "")
-					<< "\"" << ",shape=rectangle,fillcolor=wheat,style=filled];\n";
-				}
-			}
+			dotStream << "\t\"" << 
+			node.index 
+			<< "\" [label=\"" << node.label << "\"" 
+			<< (node.highlighted ? ",style=filled,fillcolor=red": "")
+			<< "];\n";
+		}
+		else if (node.kind == PDG_NODE_DECLARE)
+		{
+			dotStream << "\t\"" << 
+			node.index 
+			<< "\" [label=\"" << node.index << "\\n"
+			<< "declare(" << node.var << "): "
+			<< node.line << "," << node.col
+			<< "\"" << ",shape=rectangle,fillcolor=wheat,style=filled];\n";
 		}
+	}
 
-		dotStream << "\n\n";
-		
-		// Now print all outgoing edges and their labels
-		for (auto e : getEdges())
-		{	
-			if(
-				e->getType() == EdgeDepType::RAW
-				|| e->getType() == EdgeDepType::WAR
-				|| e->getType() == EdgeDepType::WAW 				
-			){	
-				std::string srcName = e->getSrc()->getItem()->getOperand(isa<StoreInst>(e->getSrc()->getItem()) ? 1 : 0)->getName().str();
-				std::string dstName = e->getDst()->getItem()->getOperand(isa<StoreInst>(e->getDst()->getItem()) ? 1 : 0)->getName().str();
-				if(srcName == dstName)
-					dotStream << "\t\""
-						<< getNodeIndex(e->getSrc()) 
-						<< "\" -> \"" << getNodeIndex(e->getDst()) 
-						<< "\" [label=\"" /*<< edgeLabel(e)*/ << "\"];\n"
-					;	
-			}else if(e->getType() == EdgeDepType::CTR){
-				dotStream << "\t\"" 
-					<< getNodeIndex(e->getSrc()) 
-					<< "\" -> \"" << getNodeIndex(e->getDst()) 
-					<< "\" [style=dotted];\n"
-				;
-			}else{
-				dotStream << "\t\"" << getNodeIndex(e->getSrc()) << "\" -> \"" << getNodeIndex(e->getDst()) << "\" [label=\"" << edgeLabel(e) << "\"];\n";
-			}
+	dotStream << "\n\n";
+	
+	// Now print all outgoing edges and their labels
+	for (const EdgeInfo &e : edges)
+	{	
+		if(
+			e.type == EdgeDepType::RAW
+			|| e.type == EdgeDepType::WAR
+			|| e.type == EdgeDepType::WAW 				
+		){	
+			if(e.sameVar)
+				dotStream << "\t\""
+					<< e.src 
+					<< "\" -> \"" << e.dst 
+					<< "\" [label=\"" /*<< edgeLabel(e)*/ << "\"];\n"
+				;	
+		}else if(e.type == EdgeDepType::CTR){
+			dotStream << "\t\"" 
+				<< e.src 
+				<< "\" -> \"" << e.dst 
+				<< "\" [style=dotted];\n"
+			;
+		}else{
+			dotStream << "\t\"" << e.src << "\" -> \"" << e.dst << "\" [label=\"" << e.label << "\"];\n";
 		}
-		
-		dotStream << "}";
-		dotStream.close();
 	}
+	
+	dotStream << "}";
+}
 
-	// errs() << "Finished generating dot file for " << functionName << "\n";
-	// errs() << "\n\n";
+void PDGSnapshot::renderInstructionInfo(raw_ostream &stream) const
+{
+	for (const NodeInfo &node : nodes)
+	{
+		if (node.isolated && node.hasDebugLoc && (node.kind == PDG_NODE_READ || node.kind == PDG_NODE_WRITE))
+		{
+			stream 
+				<< (node.kind == PDG_NODE_WRITE ? "w" : "r")
+				<< "|" << node.var
+				<< "|" << node.line
+				<< "|" << node.col
+				<< "\n"
+			;
+		}
+	}
 }
 
-void PDG::dumpInstructionInfo(){
-	errs() << "dumpInstructionInfo()\n";
-	ofstream stream;
-	stream.open(functionName + "_intructions.txt");
-	if (!stream.is_open())
+void PDGSnapshot::renderBinary(raw_ostream &stream) const
+{
+	vector<PDGBinaryNode> binaryNodes;
+	vector<PDGBinaryEdge> binaryEdges;
+	vector<uint32_t> stringOffsets;
+	string stringTable;
+	map<string, uint32_t> stringIds;
+	auto getStringId = [&](const string &str)->uint32_t
 	{
-		errs() << "Problem opening DOT file: " << functionName << "_instructions.txt\n";
-		return;
+		if (str.empty())
+			return PDG_BINARY_NO_STRING;
+		auto it = stringIds.find(str);
+		if (it != stringIds.end())
+			return it->second;
+		uint32_t id = stringOffsets.size();
+		stringIds[str] = id;
+		stringOffsets.push_back(stringTable.size());
+		stringTable += str;
+		stringTable += '\0';
+		return id;
+	};
+
+	// Edges refer to the node index, which is the position in nodes
+	for (const NodeInfo &node : nodes)
+	{
+		PDGBinaryNode n;
+		n.line = node.line;
+		n.col = node.col;
+		n.var = getStringId(node.var);
+		n.file = getStringId(node.file);
+		n.kind = node.kind | (node.highlighted ? 0x100 : 0);
+		binaryNodes.push_back(n);
 	}
-	for (auto node : getNodes())
+
+	for (const EdgeInfo &e : edges)
 	{
-		if(node != entry && node != exit && getInEdges(node).empty() && getOutEdges(node).empty()){
-			DebugLoc dl = node->getItem()->getDebugLoc();
-			if(dl && (isa<StoreInst>(*node->getItem()) || isa<LoadInst>(*node->getItem()))){
-				bool isWrite = isa<StoreInst>(node->getItem());
-				stream 
-					<< (isWrite ? "w" : "r")
-					<< "|" << node->getItem()->getOperand(isWrite ? 1 : 0)->getName().str()
-					<< "|" << dl.getLine()
-					<< "|" << dl.getCol()
-					<< "\n"
-				;
-			}
-		}
+		PDGBinaryEdge edge;
+		edge.src = e.src;
+		edge.dst = e.dst;
+		edge.type = e.type;
+		binaryEdges.push_back(edge);
 	}
-	stream.close();
+
+	PDGBinaryHeader header;
+	memcpy(header.magic, PDG_BINARY_MAGIC, 4);
+	header.version = PDG_BINARY_VERSION;
+	header.numNodes = binaryNodes.size();
+	header.numEdges = binaryEdges.size();
+	header.numStrings = stringOffsets.size();
+	header.stringTableSize = stringTable.size();
+
+	stream.write((const char*)&header, sizeof(header));
+	stream.write((const char*)binaryNodes.data(), binaryNodes.size() * sizeof(PDGBinaryNode));
+	stream.write((const char*)binaryEdges.data(), binaryEdges.size() * sizeof(PDGBinaryEdge));
+	for (uint32_t offset : stringOffsets)
+	{
+		support::ulittle32_t value;
+		value = offset;
+		stream.write((const char*)&value, sizeof(value));
+	}
+	stream.write(stringTable.data(), stringTable.size());
+}
+
+// Writes a snapshot of the graph on the calling thread
+static void writeSnapshot(const std::string &fileName, std::function<void(raw_ostream&)> render)
+{
+	uint64_t size;
+	std::string error;
+	if (!OutputWriter::writeFile(fileName, render, size, error))
+		errs() << error << "\n";
+}
+
+void PDG::dumpToDot(){
+	std::string graphName = outputPath(functionName + ".dot");
+	this->dumpToDot(graphName);
+}
+
+void PDG::dumpToDot(std::string graphName)
+{
+	std::shared_ptr<const PDGSnapshot> snap = snapshot();
+	writeSnapshot(graphName, [&](raw_ostream &os) { snap->renderDot(os); });
+}
+
+void PDG::dumpInstructionInfo(){
+	errs() << "dumpInstructionInfo()\n";
+	std::shared_ptr<const PDGSnapshot> snap = snapshot();
+	writeSnapshot(outputPath(functionName + "_intructions.txt"), [&](raw_ostream &os) { snap->renderInstructionInfo(os); });
+}
+
+void PDG::dumpToBinary(std::string fileName)
+{
+	std::shared_ptr<const PDGSnapshot> snap = snapshot();
+	writeSnapshot(fileName, [&](raw_ostream &os) { snap->renderBinary(os); });
 }
 
 void PDG::connectToEntry(Instruction* inst)
@@ -227,6 +377,125 @@ void PDG::connectToExit(Instruction* inst)
 	addEdge(n, exit, EdgeDepType::CTR);
 }
 
+void PDGUpdateHandle::deleted()
+{
+	pdg->removeInstruction(inst);
+}
+
+void PDGUpdateHandle::allUsesReplacedWith(Value *newValue)
+{
+	pdg->replaceInstruction(inst, newValue);
+}
+
+void PDG::trackUpdates()
+{
+	tracking = true;
+	for (Node<Instruction*> *n : getNodes())
+	{
+		if (!isVirtual(n) && !updateHandles.count(n->getItem()))
+			updateHandles[n->getItem()] = std::unique_ptr<PDGUpdateHandle>(new PDGUpdateHandle(this, n->getItem()));
+	}
+}
+
+void PDG::removeInstruction(Instruction *inst)
+{
+	if (getNodeIndex(inst) != -1)
+	{
+		Node<Instruction*> *node = getNode(inst);
+		for (Edge<Instruction*, EdgeDepType> in : getInEdges(node, typeMask(EdgeDepType::CTR)))
+		{
+			if (in.getSrc() == node)
+				continue;
+			for (Edge<Instruction*, EdgeDepType> out : getOutEdges(node, typeMask(EdgeDepType::CTR)))
+			{
+				if (out.getDst() != node)
+					addEdge(in.getSrc(), out.getDst(), EdgeDepType::CTR);
+			}
+		}
+		removeNode(node);
+	}
+	// Destroys the handle, possibly the one calling us
+	updateHandles.erase(inst);
+}
+
+void PDG::replaceInstruction(Instruction *oldInst, Value *newValue)
+{
+	Instruction *newInst = dyn_cast<Instruction>(newValue);
+	if (!newInst || !(isa<LoadInst>(newInst) || isa<StoreInst>(newInst)) || getNodeIndex(newInst) != -1)
+	{
+		// The access is gone, or merged into one that is already in the graph
+		removeInstruction(oldInst);
+		return;
+	}
+	if (getNodeIndex(oldInst) == -1)
+		return;
+
+	Node<Instruction*> *from = getNode(oldInst);
+	Node<Instruction*> *to = getNode(newInst);
+	for (Edge<Instruction*, EdgeDepType> e : getOutEdges(from))
+		addEdge(to, e.getDst() == from ? to : e.getDst(), e.getType());
+	for (Edge<Instruction*, EdgeDepType> e : getInEdges(from))
+	{
+		if (e.getSrc() != from)
+			addEdge(e.getSrc(), to, e.getType());
+	}
+	if (from->isHighlighted())
+		to->highlight();
+	removeNode(from);
+	updateHandles.erase(oldInst);
+	if (tracking)
+		updateHandles[newInst] = std::unique_ptr<PDGUpdateHandle>(new PDGUpdateHandle(this, newInst));
+}
+
+bool PDG::insertInstruction(Instruction *inst)
+{
+	if (getNodeIndex(inst) != -1)
+		return true;
+	Instruction *prev = nullptr, *next = nullptr;
+	for (Instruction *I = inst->getPrevNode(); I && !prev; I = I->getPrevNode())
+	{
+		if (getNodeIndex(I) != -1)
+			prev = I;
+	}
+	for (Instruction *I = inst->getNextNode(); I && !next; I = I->getNextNode())
+	{
+		if (getNodeIndex(I) != -1)
+			next = I;
+	}
+	if (!prev && !next)
+		return false;
+
+	Node<Instruction*> *node = getNode(inst);
+	if (prev)
+	{
+		// inst takes over the control successors of prev
+		Node<Instruction*> *prevNode = getNode(prev);
+		vector<Edge<Instruction*, EdgeDepType>> ctrSuccessors = getOutEdges(prevNode, typeMask(EdgeDepType::CTR)).toVector();
+		for (Edge<Instruction*, EdgeDepType> &e : ctrSuccessors)
+		{
+			addEdge(node, e.getDst(), EdgeDepType::CTR);
+			removeEdge(e);
+		}
+		addEdge(prevNode, node, EdgeDepType::CTR);
+	}
+	else
+	{
+		// inst is the first one of its block, it takes over the control
+		// predecessors of next
+		Node<Instruction*> *nextNode = getNode(next);
+		vector<Edge<Instruction*, EdgeDepType>> ctrPredecessors = getInEdges(nextNode, typeMask(EdgeDepType::CTR)).toVector();
+		for (Edge<Instruction*, EdgeDepType> &e : ctrPredecessors)
+		{
+			addEdge(e.getSrc(), node, EdgeDepType::CTR);
+			removeEdge(e);
+		}
+		addEdge(node, nextNode, EdgeDepType::CTR);
+	}
+	if (tracking)
+		updateHandles[inst] = std::unique_ptr<PDGUpdateHandle>(new PDGUpdateHandle(this, inst));
+	return true;
+}
+
 map<string, set<string>> PDG::getDPDepMap(){
 	map<string, string> filemap;
 	if(fmap.length() > 0){
@@ -251,13 +520,13 @@ map<string, set<string>> PDG::getDPDepMap(){
 	Instruction *SrcI, *DstI;
 	DebugLoc srcDL, dstDL, dl;
 
-	string varNameSrc, varNameDst, srcLine, dstLine, fileID;
+	string varNameSrc, varNameDst, srcLine, dstLine, fileID, depType;
     
 	std::regex r (".+\\.[0-9]+");
 	for(auto edge: getEdges()){
-		if(edge->getType() != EdgeDepType::SCA && edge->getType() != EdgeDepType::RAR){
-			SrcI = edge->getSrc()->getItem();
-			DstI = edge->getDst()->getItem();
+		if(edge.getType() != EdgeDepType::SCA && edge.getType() != EdgeDepType::RAR){
+			SrcI = edge.getSrc()->getItem();
+			DstI = edge.getDst()->getItem();
 
 			srcDL = SrcI->getDebugLoc();
 			dstDL = DstI->getDebugLoc();
@@ -274,7 +543,7 @@ map<string, set<string>> PDG::getDPDepMap(){
 			}
 			
 			/*
-			if(getNodeIndex(edge->getSrc()) <= getNodeIndex(edge->getDst())){
+			if(getNodeIndex(edge.getSrc()) <= getNodeIndex(edge.getDst())){
 				// Deps when SRC is after DST in code should only happen in a loop
 				Loop *LDst = LI->getLoopFor((&*DstI)->getParent());
 				Loop *LSrc = LI->getLoopFor((&*SrcI)->getParent());	
@@ -301,7 +570,11 @@ map<string, set<string>> PDG::getDPDepMap(){
 			}
 			
 			dstLine = fileID + ":" + to_string(srcDL.getLine()); //+ "|" + varNameDst;// + "," + to_string(dstDL.getCol());
-			srcLine = edgeLabel(edge) + " " + fileID + ":" + to_string(dstDL.getLine()) + "|" + varNameSrc;
+			// DiscoPoP's dependence format has no loop-carried marker
+			depType = edgeLabel(edge);
+			if (depType.back() == '*')
+				depType.pop_back();
+			srcLine = depType + " " + fileID + ":" + to_string(dstDL.getLine()) + "|" + varNameSrc;
 										
 			if (depMap.find(dstLine) == depMap.end()) {
 				set<string> s;
@@ -21,6 +21,7 @@
 #include "llvm/Analysis/DominanceFrontier.h"
 #include "llvm/Analysis/PostDominators.h"
 #include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/ValueHandle.h"
 
 //STL IMPORTS
 #include <string>
@@ -28,58 +29,137 @@
 #include <map>
 #include <set>
 #include <queue>
+#include <memory>
 
 //LOCAL IMPORTS
 #include "Graph.hpp"
 #include "EdgeDepType.h"
-
-#define ENTRY 1000000
-#define EXIT 2000000
+#include "PDGBinary.h"
 
 using namespace llvm;
 using namespace std;
 
+class PDG;
+
+// Copy of a PDG with everything its dumps need. It doesn't refer to the graph
+// or the IR, so it can be rendered after they changed, e.g. by an
+// OutputWriter on another thread
+struct PDGSnapshot
+{
+	struct NodeInfo
+	{
+		int index;
+		PDGBinaryNodeKind kind;
+		bool highlighted;
+		bool isolated;      // no in or out edges
+		bool hasDebugLoc;
+		unsigned line;
+		unsigned col;
+		std::string var;    // accessed or declared variable
+		std::string file;
+		std::string label;  // DOT label of reads and writes
+	};
+	struct EdgeInfo
+	{
+		int src;
+		int dst;
+		EdgeDepType type;
+		bool sameVar;       // RAW/WAR/WAW between accesses of the same variable
+		std::string label;  // edge label of the other non-CTR types
+	};
+
+	// By node index, so nodes[i].index == i. Indices of removed nodes hold
+	// PDG_NODE_REMOVED placeholders
+	std::vector<NodeInfo> nodes;
+	std::vector<EdgeInfo> edges;
+
+	void renderDot(raw_ostream &os) const;
+	void renderInstructionInfo(raw_ostream &os) const;
+	void renderBinary(raw_ostream &os) const;
+};
+
+// Notifies a PDG when one of its instructions is deleted or replaced
+class PDGUpdateHandle : public CallbackVH
+{
+private:
+	PDG *pdg;
+	Instruction *inst;
+
+public:
+	PDGUpdateHandle(PDG *pdg, Instruction *inst)
+		: CallbackVH(inst)
+		, pdg(pdg)
+		, inst(inst)
+		{}
+	void deleted() override;
+	void allUsesReplacedWith(Value *newValue) override;
+};
+
 class PDG : public Graph<Instruction*, EdgeDepType>
 {
+public:
+	// The entry and exit nodes are virtual nodes without an instruction and
+	// always have these indices
+	static const int ENTRY_INDEX = 0;
+	static const int EXIT_INDEX = 1;
+
 private:
 	std::string functionName;
 	Function *F;
 	Node<Instruction*> *entry;
 	Node<Instruction*> *exit;
 	std::set<Graph<Instruction*, EdgeDepType>* > scSubgraphs;
+	bool tracking = false;
+	std::map<Instruction*, std::unique_ptr<PDGUpdateHandle> > updateHandles;
 
 public:
 	PDG(std::string fName, Function *F)
 		: functionName(fName)
 		, F(F)
-		, entry(nullptr)
-		, exit(nullptr)
 		{
-			entry = addNode((Instruction*)ENTRY);
-			exit = addNode((Instruction*)EXIT);
+			reserveNodes(F->getInstructionCount() + 2);
+			entry = addVirtualNode();
+			exit = addVirtualNode();
 		}
 	PDG()
 		: functionName("NONE")
 		, F(nullptr)
-		, entry(nullptr)
-		, exit(nullptr)
-		{}
-	~PDG()
-	{
-		delete entry;
-		delete exit;
-	}
+		{
+			entry = addVirtualNode();
+			exit = addVirtualNode();
+		}
 
+	std::shared_ptr<const PDGSnapshot> snapshot();
 	void dumpToDot(std::string graphName);
 	void dumpToDot();
 	void dumpInstructionInfo();
-	std::string edgeLabel(Edge<Instruction*, EdgeDepType> *e);
+	void dumpToBinary(std::string fileName);
+	std::string edgeLabel(const Edge<Instruction*, EdgeDepType> &e);
 	std::string nodeLabel(Instruction* inst);
 	void connectToEntry(Instruction* inst);
 	void connectToExit(Instruction* inst);
 	Node<Instruction*> *getEntry() { return entry; }
 	Node<Instruction*> *getExit() { return exit; }
+	bool isEntry(Node<Instruction*> *node) const { return getNodeIndex(node) == ENTRY_INDEX; }
+	bool isExit(Node<Instruction*> *node) const { return getNodeIndex(node) == EXIT_INDEX; }
+	// Entry or exit
+	bool isVirtual(Node<Instruction*> *node) const { return (unsigned)getNodeIndex(node) <= (unsigned)EXIT_INDEX; }
 	map<string, set<string>> getDPDepMap();
+	// Prefixes fileName with the output directory (-depOutputDir)
+	static std::string outputPath(std::string fileName);
+
+	// Incremental maintenance. After trackUpdates(), deleting an instruction
+	// removes its node, and RAUW moves the node to the replacing load/store.
+	// Removed nodes are bridged with CTR edges so the store/load CFG stays
+	// connected.
+	void trackUpdates();
+	void removeInstruction(Instruction *inst);
+	void replaceInstruction(Instruction *oldInst, Value *newValue);
+	// Splices a new load/store into the store/load CFG next to the closest
+	// instruction of its block that is in the graph. Returns false if there
+	// is none, then the graph has to be rebuilt. Dependence edges of the new
+	// instruction have to be added by the caller.
+	bool insertInstruction(Instruction *inst);
 };
 
 #endif // PDG_H
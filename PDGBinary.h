@@ -0,0 +1,135 @@
+#ifndef PDG_BINARY_H
+#define PDG_BINARY_H
+
+//LLVM IMPORTS
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+//STL IMPORTS
+#include <cstring>
+#include <memory>
+#include <string>
+
+// Versioned binary format of a PDG, written by PDG::dumpToBinary.
+// All fields are little-endian 32-bit integers, so a mapped file can be used
+// in place:
+//
+//   PDGBinaryHeader
+//   PDGBinaryNode   nodes[numNodes]      (indexed by node index)
+//   PDGBinaryEdge   edges[numEdges]
+//   uint32          stringOffsets[numStrings]
+//   char            strings[stringTableSize]  (null-terminated)
+//
+// Strings hold variable and file names; NO_STRING marks a missing one.
+// Edges refer to nodes by index. The slots of nodes removed from the graph
+// are kept as PDG_NODE_REMOVED records without edges.
+#define PDG_BINARY_MAGIC "DPDG"
+#define PDG_BINARY_VERSION 2
+#define PDG_BINARY_NO_STRING 0xFFFFFFFF
+
+enum PDGBinaryNodeKind { PDG_NODE_ENTRY, PDG_NODE_EXIT, PDG_NODE_READ, PDG_NODE_WRITE, PDG_NODE_DECLARE, PDG_NODE_OTHER, PDG_NODE_REMOVED };
+
+struct PDGBinaryHeader
+{
+	char magic[4];
+	llvm::support::ulittle32_t version;
+	llvm::support::ulittle32_t numNodes;
+	llvm::support::ulittle32_t numEdges;
+	llvm::support::ulittle32_t numStrings;
+	llvm::support::ulittle32_t stringTableSize;
+};
+
+struct PDGBinaryNode
+{
+	llvm::support::ulittle32_t line;
+	llvm::support::ulittle32_t col;
+	llvm::support::ulittle32_t var;   // string index
+	llvm::support::ulittle32_t file;  // string index
+	llvm::support::ulittle32_t kind;  // PDGBinaryNodeKind, bit 8: highlighted
+};
+
+struct PDGBinaryEdge
+{
+	llvm::support::ulittle32_t src;
+	llvm::support::ulittle32_t dst;
+	llvm::support::ulittle32_t type;  // EdgeDepType
+};
+
+// Maps a binary PDG and gives direct access to its arrays
+class PDGBinaryReader
+{
+private:
+	std::unique_ptr<llvm::MemoryBuffer> buffer;
+	const PDGBinaryHeader *header = nullptr;
+	const PDGBinaryNode *nodes = nullptr;
+	const PDGBinaryEdge *edges = nullptr;
+	const llvm::support::ulittle32_t *stringOffsets = nullptr;
+	const char *strings = nullptr;
+
+public:
+	// Returns false if the file can't be read or is not a valid binary PDG,
+	// including edges to nodes and strings outside of the file
+	bool open(const std::string &fileName)
+	{
+		auto bufferOrError = llvm::MemoryBuffer::getFile(fileName);
+		if (!bufferOrError)
+			return false;
+		buffer = std::move(*bufferOrError);
+
+		const char *data = buffer->getBufferStart();
+		size_t size = buffer->getBufferSize();
+		if (size < sizeof(PDGBinaryHeader))
+			return false;
+		header = reinterpret_cast<const PDGBinaryHeader*>(data);
+		if (std::memcmp(header->magic, PDG_BINARY_MAGIC, 4) != 0 || header->version != PDG_BINARY_VERSION)
+			return false;
+
+		size_t offset = sizeof(PDGBinaryHeader);
+		size_t expected = offset
+			+ (size_t)header->numNodes * sizeof(PDGBinaryNode)
+			+ (size_t)header->numEdges * sizeof(PDGBinaryEdge)
+			+ (size_t)header->numStrings * sizeof(llvm::support::ulittle32_t)
+			+ header->stringTableSize;
+		if (size < expected)
+			return false;
+
+		nodes = reinterpret_cast<const PDGBinaryNode*>(data + offset);
+		offset += header->numNodes * sizeof(PDGBinaryNode);
+		edges = reinterpret_cast<const PDGBinaryEdge*>(data + offset);
+		offset += header->numEdges * sizeof(PDGBinaryEdge);
+		stringOffsets = reinterpret_cast<const llvm::support::ulittle32_t*>(data + offset);
+		offset += header->numStrings * sizeof(llvm::support::ulittle32_t);
+		strings = data + offset;
+		if (header->stringTableSize != 0 && strings[header->stringTableSize - 1] != '\0')
+			return false;
+
+		// Checked once here, so the arrays can be used in place
+		for (unsigned i = 0; i < header->numEdges; ++i)
+		{
+			if (edges[i].src >= header->numNodes || edges[i].dst >= header->numNodes)
+				return false;
+		}
+		for (unsigned i = 0; i < header->numStrings; ++i)
+		{
+			if (stringOffsets[i] >= header->stringTableSize)
+				return false;
+		}
+		return true;
+	}
+
+	unsigned getNumNodes() const { return header->numNodes; }
+	unsigned getNumEdges() const { return header->numEdges; }
+	const PDGBinaryNode &getNode(unsigned index) const { return nodes[index]; }
+	const PDGBinaryEdge &getEdge(unsigned index) const { return edges[index]; }
+	PDGBinaryNodeKind getKind(unsigned index) const { return (PDGBinaryNodeKind)(nodes[index].kind & 0xFF); }
+	bool isHighlighted(unsigned index) const { return nodes[index].kind & 0x100; }
+
+	const char *getString(unsigned index) const
+	{
+		if (index == PDG_BINARY_NO_STRING || index >= header->numStrings)
+			return "";
+		return strings + stringOffsets[index];
+	}
+};
+
+#endif // PDG_BINARY_H
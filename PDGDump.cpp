@@ -0,0 +1,93 @@
+//===- PDGDump.cpp - Print a binary PDG -----------------------------------===//
+//
+// Prints a PDG written by -dumpBinary (PDG::dumpToBinary) as text, one line
+// per node slot and edge:
+//
+//   node <index> <kind> <line>:<col> <var>
+//   edge <src index> <dst index> <type>
+//
+// Slots of removed nodes are printed as "node <index> removed".
+//
+//===----------------------------------------------------------------------===//
+
+//LOCAL IMPORTS
+#include "EdgeDepType.h"
+#include "PDGBinary.h"
+
+//LLVM IMPORTS
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/raw_ostream.h"
+
+//STL IMPORTS
+#include <string>
+
+using namespace llvm;
+
+static cl::opt<std::string> inputFilename(cl::Positional, cl::desc("<binary PDG>"), cl::Required);
+
+static const char *getKindName(PDGBinaryNodeKind kind)
+{
+	switch (kind)
+	{
+		case PDG_NODE_ENTRY: return "entry";
+		case PDG_NODE_EXIT: return "exit";
+		case PDG_NODE_READ: return "read";
+		case PDG_NODE_WRITE: return "write";
+		case PDG_NODE_DECLARE: return "declare";
+		case PDG_NODE_REMOVED: return "removed";
+		default: return "other";
+	}
+}
+
+// Same names as PDG::edgeLabel
+static std::string getTypeName(unsigned type)
+{
+	switch (type)
+	{
+		case EdgeDepType::RAR: return "RAR";
+		case EdgeDepType::RAWLC: return "RAW*";
+		case EdgeDepType::WARLC: return "WAR*";
+		case EdgeDepType::WAWLC: return "WAW*";
+		case EdgeDepType::WAW: return "WAW";
+		case EdgeDepType::RAW: return "RAW";
+		case EdgeDepType::WAR: return "WAR";
+		case EdgeDepType::CTR: return "CTR";
+		case EdgeDepType::PARENT: return "PARENT";
+		case EdgeDepType::SCA: return "SCA";
+		default: return std::to_string(type);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	InitLLVM X(argc, argv);
+	cl::ParseCommandLineOptions(argc, argv, "Binary PDG printer\n");
+
+	PDGBinaryReader reader;
+	if (!reader.open(inputFilename))
+	{
+		errs() << "Not a valid binary PDG of version " << PDG_BINARY_VERSION << ": " << inputFilename << "\n";
+		return 1;
+	}
+
+	for (unsigned i = 0; i < reader.getNumNodes(); ++i)
+	{
+		const PDGBinaryNode &node = reader.getNode(i);
+		PDGBinaryNodeKind kind = reader.getKind(i);
+		outs() << "node " << i << " " << getKindName(kind);
+		if (kind != PDG_NODE_REMOVED)
+		{
+			std::string var = reader.getString(node.var);
+			outs() << " " << (unsigned)node.line << ":" << (unsigned)node.col << " " << (var.empty() ? "-" : var)
+				<< (reader.isHighlighted(i) ? " highlighted" : "");
+		}
+		outs() << "\n";
+	}
+	for (unsigned i = 0; i < reader.getNumEdges(); ++i)
+	{
+		const PDGBinaryEdge &edge = reader.getEdge(i);
+		outs() << "edge " << (unsigned)edge.src << " " << (unsigned)edge.dst << " " << getTypeName(edge.type) << "\n";
+	}
+	return 0;
+}
@@ -0,0 +1,295 @@
+//===- PDGUpdateTest.cpp - Apply IR updates to a tracked PDG --------------===//
+//
+// Test driver of the incremental PDG maintenance. It builds the store/load CFG
+// of a function with the dependences between accesses of the same pointer,
+// calls PDG::trackUpdates() and then changes the IR as its metadata says:
+//
+//   !pdg.erase    the access is erased
+//   !pdg.rauw     the access is replaced with a copy of it (RAUW + erase)
+//   !pdg.insert   the access is taken out of the function before the graph is
+//                 built and put back with PDG::insertInstruction() afterwards
+//
+// Erasures and replacements are applied in program order, insertions after
+// them. The resulting graph is printed as
+//
+//   node <index> <kind> <line>:<col> <var>
+//   edge <src index> <dst index> <type>
+//
+// the same format pdg-dump prints a binary PDG (-o) in.
+//
+//===----------------------------------------------------------------------===//
+
+//LOCAL IMPORTS
+#include "PDG.h"
+
+//LLVM IMPORTS
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+
+//STL IMPORTS
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+static cl::opt<std::string> inputFilename(cl::Positional, cl::desc("<input IR file>"), cl::Required);
+static cl::opt<std::string> functionName("function", cl::desc("Function to build the PDG of (default: the first definition)"), cl::value_desc("name"));
+static cl::opt<std::string> outputFilename("o", cl::desc("Also write the updated PDG in the binary format"), cl::value_desc("filename"));
+
+static bool isAccess(const Instruction *I)
+{
+	return isa<LoadInst>(I) || isa<StoreInst>(I);
+}
+
+static Value *getPointer(Instruction *I)
+{
+	return I->getOperand(isa<StoreInst>(I) ? 1 : 0);
+}
+
+static std::vector<Instruction*> getAccesses(Function &F)
+{
+	std::vector<Instruction*> accesses;
+	for (Instruction &I : instructions(F))
+	{
+		if (isAccess(&I))
+			accesses.push_back(&I);
+	}
+	return accesses;
+}
+
+// Adds the dependence of the later access on the earlier one if both access
+// the same pointer and one of them writes
+static void addDependence(PDG &G, Instruction *earlier, Instruction *later)
+{
+	if (getPointer(earlier) != getPointer(later) || (isa<LoadInst>(earlier) && isa<LoadInst>(later)))
+		return;
+	if (isa<LoadInst>(later))
+		G.addEdge(later, earlier, EdgeDepType::RAW);
+	else if (isa<LoadInst>(earlier))
+		G.addEdge(later, earlier, EdgeDepType::WAR);
+	else
+		G.addEdge(later, earlier, EdgeDepType::WAW);
+}
+
+// Collects the first accesses on the paths starting at BB. Returns true if a
+// path reaches a return without passing one
+static bool collectFirstAccesses(BasicBlock *BB, std::set<BasicBlock*> &visited, std::set<Instruction*> &firsts)
+{
+	if (!visited.insert(BB).second)
+		return false;
+	for (Instruction &I : *BB)
+	{
+		if (isAccess(&I))
+		{
+			firsts.insert(&I);
+			return false;
+		}
+	}
+	bool reachesExit = isa<ReturnInst>(BB->getTerminator());
+	for (BasicBlock *succ : successors(BB))
+		reachesExit |= collectFirstAccesses(succ, visited, firsts);
+	return reachesExit;
+}
+
+// Connects the accesses of each block in order, the last one to the first
+// accesses that can follow it
+static void addControlEdges(PDG &G, Function &F)
+{
+	std::set<BasicBlock*> visited;
+	std::set<Instruction*> firsts;
+	if (collectFirstAccesses(&F.getEntryBlock(), visited, firsts))
+		G.addEdge(G.getEntry(), G.getExit(), EdgeDepType::CTR);
+	for (Instruction *I : firsts)
+		G.connectToEntry(I);
+
+	for (BasicBlock &BB : F)
+	{
+		Instruction *last = nullptr;
+		for (Instruction &I : BB)
+		{
+			if (!isAccess(&I))
+				continue;
+			if (last)
+				G.addEdge(last, &I, EdgeDepType::CTR);
+			last = &I;
+		}
+		if (!last)
+			continue;
+
+		visited.clear();
+		firsts.clear();
+		bool reachesExit = isa<ReturnInst>(BB.getTerminator());
+		for (BasicBlock *succ : successors(&BB))
+			reachesExit |= collectFirstAccesses(succ, visited, firsts);
+		for (Instruction *I : firsts)
+			G.addEdge(last, I, EdgeDepType::CTR);
+		if (reachesExit)
+			G.connectToExit(last);
+	}
+}
+
+static const char *getKindName(PDG &G, Node<Instruction*> *node)
+{
+	if (G.isEntry(node))
+		return "entry";
+	if (G.isExit(node))
+		return "exit";
+	return isa<StoreInst>(node->getItem()) ? "write" : "read";
+}
+
+static void printGraph(PDG &G, raw_ostream &os)
+{
+	for (int i = 0; i < G.getNumNodeIndices(); ++i)
+	{
+		Node<Instruction*> *node = G.getNodeByIndex(i);
+		if (node == nullptr)
+			continue;
+		unsigned line = 0, col = 0;
+		std::string var;
+		if (!G.isVirtual(node))
+		{
+			if (DebugLoc dl = node->getItem()->getDebugLoc())
+			{
+				line = dl.getLine();
+				col = dl.getCol();
+			}
+			var = getPointer(node->getItem())->getName().str();
+		}
+		os << "node " << i << " " << getKindName(G, node) << " " << line << ":" << col << " " << (var.empty() ? "-" : var)
+			<< (node->isHighlighted() ? " highlighted" : "") << "\n";
+	}
+	for (auto e : G.getEdges())
+		os << "edge " << G.getNodeIndex(e.getSrc()) << " " << G.getNodeIndex(e.getDst()) << " " << G.edgeLabel(e) << "\n";
+}
+
+int main(int argc, char **argv)
+{
+	InitLLVM X(argc, argv);
+	cl::ParseCommandLineOptions(argc, argv, "PDG update test driver\n");
+
+	LLVMContext context;
+	SMDiagnostic err;
+	std::unique_ptr<Module> M = parseIRFile(inputFilename, err, context);
+	if (!M)
+	{
+		err.print(argv[0], errs());
+		return 1;
+	}
+	Function *F = nullptr;
+	for (Function &Fn : *M)
+	{
+		if (!Fn.isDeclaration() && (functionName.empty() || Fn.getName() == functionName))
+		{
+			F = &Fn;
+			break;
+		}
+	}
+	if (!F)
+	{
+		errs() << "No function matches " << functionName << "\n";
+		return 1;
+	}
+
+	// Taken out before the graph is built, with the instruction to put them
+	// back in front of
+	std::vector<std::pair<Instruction*, Instruction*>> inserts;
+	std::vector<Instruction*> erases, replacements;
+	for (Instruction *I : getAccesses(*F))
+	{
+		if (I->getMetadata("pdg.insert"))
+			inserts.push_back({I, I->getNextNode()});
+		else if (I->getMetadata("pdg.erase"))
+			erases.push_back(I);
+		else if (I->getMetadata("pdg.rauw"))
+			replacements.push_back(I);
+	}
+	for (auto &insert : inserts)
+		insert.first->removeFromParent();
+
+	PDG G(F->getName().str(), F);
+	std::vector<Instruction*> accesses = getAccesses(*F);
+	for (Instruction *I : accesses)
+		G.getNode(I);
+	addControlEdges(G, *F);
+	for (unsigned j = 0; j < accesses.size(); ++j)
+	{
+		for (unsigned i = 0; i < j; ++i)
+			addDependence(G, accesses[i], accesses[j]);
+	}
+	G.trackUpdates();
+
+	// The graph learns about these through its update handles
+	for (Instruction *I : getAccesses(*F))
+	{
+		if (std::find(erases.begin(), erases.end(), I) != erases.end())
+		{
+			outs() << "erase " << G.getNodeIndex(I) << "\n";
+			if (!I->use_empty())
+				I->replaceAllUsesWith(UndefValue::get(I->getType()));
+			I->eraseFromParent();
+		}
+		else if (std::find(replacements.begin(), replacements.end(), I) != replacements.end())
+		{
+			Instruction *copy = I->clone();
+			copy->setMetadata("pdg.rauw", nullptr);
+			copy->insertBefore(I);
+			if (I->hasName())
+				copy->takeName(I);
+			int oldIndex = G.getNodeIndex(I);
+			I->replaceAllUsesWith(copy);
+			I->eraseFromParent();
+			outs() << "rauw " << oldIndex << " " << G.getNodeIndex(copy) << "\n";
+		}
+	}
+
+	for (auto &insert : inserts)
+	{
+		Instruction *I = insert.first;
+		I->insertBefore(insert.second);
+		if (!G.insertInstruction(I))
+		{
+			outs() << "insert rebuild\n";
+			continue;
+		}
+		// Dependence edges of inserted accesses are up to the caller
+		std::vector<Instruction*> order = getAccesses(*F);
+		auto pos = std::find(order.begin(), order.end(), I);
+		for (auto it = order.begin(); it != order.end(); ++it)
+		{
+			if (G.getNodeIndex(*it) == -1 || *it == I)
+				continue;
+			if (it < pos)
+				addDependence(G, *it, I);
+			else
+				addDependence(G, I, *it);
+		}
+		outs() << "insert " << G.getNodeIndex(I) << "\n";
+	}
+
+	// Every node has to refer to an instruction that is still in F
+	std::set<Instruction*> live;
+	for (Instruction &I : instructions(*F))
+		live.insert(&I);
+	for (Node<Instruction*> *node : G.getNodes())
+	{
+		if (!G.isVirtual(node) && !live.count(node->getItem()))
+		{
+			errs() << "Stale node " << G.getNodeIndex(node) << "\n";
+			return 1;
+		}
+	}
+
+	printGraph(G, outs());
+	if (!outputFilename.empty())
+		G.dumpToBinary(outputFilename);
+	return 0;
+}
@@ -0,0 +1,90 @@
+; loop-nocall.ll after mem2reg, only the accesses of the globals are left
+source_filename = "loop.c"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+@tab = dso_local global [100 x i32] zeroinitializer, align 16, !dbg !0
+@cfg = dso_local global i32 7, align 4, !dbg !5
+@ctab = dso_local constant [4 x i32] [i32 1, i32 2, i32 3, i32 4], align 4
+
+define dso_local i32 @helper(i32* %p) !dbg !12 {
+entry:
+  %v = load i32, i32* %p, align 4, !dbg !15
+  ret i32 %v, !dbg !15
+}
+
+define dso_local i32 @f(i32 %n) !dbg !16 {
+entry:
+  call void @llvm.dbg.value(metadata i32 %n, metadata !17, metadata !DIExpression()), !dbg !18
+  call void @llvm.dbg.value(metadata i32 0, metadata !19, metadata !DIExpression()), !dbg !18
+  call void @llvm.dbg.value(metadata i32 3, metadata !20, metadata !DIExpression()), !dbg !18
+  call void @llvm.dbg.value(metadata i32 0, metadata !21, metadata !DIExpression()), !dbg !18
+  br label %for.cond, !dbg !22
+
+for.cond:                                         ; preds = %for.inc, %entry
+  %s.0 = phi i32 [ 0, %entry ], [ %add1, %for.inc ], !dbg !18
+  %i.0 = phi i32 [ 0, %entry ], [ %inc, %for.inc ], !dbg !18
+  call void @llvm.dbg.value(metadata i32 %i.0, metadata !21, metadata !DIExpression()), !dbg !18
+  call void @llvm.dbg.value(metadata i32 %s.0, metadata !19, metadata !DIExpression()), !dbg !18
+  %cmp = icmp slt i32 %i.0, %n, !dbg !23
+  br i1 %cmp, label %for.body, label %for.end, !dbg !22
+
+for.body:                                         ; preds = %for.cond
+  %idxprom = sext i32 %i.0 to i64, !dbg !24
+  %arrayidx = getelementptr inbounds [100 x i32], [100 x i32]* @tab, i64 0, i64 %idxprom, !dbg !24
+  %0 = load i32, i32* %arrayidx, align 4, !dbg !24
+  %1 = load i32, i32* @cfg, align 4, !dbg !24
+  %add = add nsw i32 %0, 3, !dbg !24
+  %add2 = add nsw i32 %add, 3, !dbg !24
+  %add3 = add nsw i32 %add2, %1, !dbg !24
+  %add1 = add nsw i32 %s.0, %add3, !dbg !24
+  call void @llvm.dbg.value(metadata i32 %add1, metadata !19, metadata !DIExpression()), !dbg !18
+  br label %for.inc, !dbg !24
+
+for.inc:                                          ; preds = %for.body
+  %inc = add nsw i32 %i.0, 1, !dbg !25
+  call void @llvm.dbg.value(metadata i32 %inc, metadata !21, metadata !DIExpression()), !dbg !18
+  br label %for.cond, !dbg !25
+
+for.end:                                          ; preds = %for.cond
+  ret i32 %s.0, !dbg !26
+}
+
+; Function Attrs: nofree nosync nounwind readnone speculatable willreturn
+declare void @llvm.dbg.declare(metadata, metadata, metadata) #0
+
+; Function Attrs: nofree nosync nounwind readnone speculatable willreturn
+declare void @llvm.dbg.value(metadata, metadata, metadata) #0
+
+attributes #0 = { nofree nosync nounwind readnone speculatable willreturn }
+
+!llvm.dbg.cu = !{!2}
+!llvm.module.flags = !{!10, !11}
+
+!0 = !DIGlobalVariableExpression(var: !1, expr: !DIExpression())
+!1 = distinct !DIGlobalVariable(name: "tab", scope: !2, file: !3, line: 1, type: !8, isLocal: false, isDefinition: true)
+!2 = distinct !DICompileUnit(language: DW_LANG_C99, file: !3, producer: "clang", isOptimized: false, runtimeVersion: 0, emissionKind: FullDebug, globals: !4)
+!3 = !DIFile(filename: "loop.c", directory: "/tmp")
+!4 = !{!0, !5}
+!5 = !DIGlobalVariableExpression(var: !6, expr: !DIExpression())
+!6 = distinct !DIGlobalVariable(name: "cfg", scope: !2, file: !3, line: 2, type: !7, isLocal: false, isDefinition: true)
+!7 = !DIBasicType(name: "int", size: 32, encoding: DW_ATE_signed)
+!8 = !DICompositeType(tag: DW_TAG_array_type, baseType: !7, size: 3200, elements: !9)
+!9 = !{}
+!10 = !{i32 2, !"Dwarf Version", i32 4}
+!11 = !{i32 2, !"Debug Info Version", i32 3}
+!12 = distinct !DISubprogram(name: "helper", scope: !3, file: !3, line: 11, type: !13, scopeLine: 11, spFlags: DISPFlagDefinition, unit: !2, retainedNodes: !9)
+!13 = !DISubroutineType(types: !14)
+!14 = !{!7, !7}
+!15 = !DILocation(line: 11, column: 3, scope: !12)
+!16 = distinct !DISubprogram(name: "f", scope: !3, file: !3, line: 3, type: !13, scopeLine: 3, spFlags: DISPFlagDefinition, unit: !2, retainedNodes: !9)
+!17 = !DILocalVariable(name: "n", arg: 1, scope: !16, file: !3, line: 3, type: !7)
+!18 = !DILocation(line: 0, scope: !16)
+!19 = !DILocalVariable(name: "s", scope: !16, file: !3, line: 4, type: !7)
+!20 = !DILocalVariable(name: "k", scope: !16, file: !3, line: 5, type: !7)
+!21 = !DILocalVariable(name: "i", scope: !16, file: !3, line: 6, type: !7)
+!22 = !DILocation(line: 6, column: 3, scope: !16)
+!23 = !DILocation(line: 6, column: 19, scope: !16)
+!24 = !DILocation(line: 7, column: 7, scope: !16)
+!25 = !DILocation(line: 6, column: 25, scope: !16)
+!26 = !DILocation(line: 9, column: 3, scope: !16)
@@ -0,0 +1,112 @@
+; Input of several tests, the IR of
+;
+;   1  int tab[100];
+;   2  int cfg = 7;
+;   3  int f(int n) {
+;   4    int s = 0;
+;   5    int k = 3;
+;   6    for (int i = 0; i < n; i++)
+;   7      s += tab[i] + k + k + cfg + helper(&k);
+;   8
+;   9    return s;
+;  10  }
+;  11  int helper(int *p) { return *p; }
+source_filename = "loop.c"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+@tab = dso_local global [100 x i32] zeroinitializer, align 16, !dbg !0
+@cfg = dso_local global i32 7, align 4, !dbg !30
+@ctab = dso_local constant [4 x i32] [i32 1, i32 2, i32 3, i32 4], align 4
+
+define dso_local i32 @helper(i32* %p) !dbg !40 {
+entry:
+  %v = load i32, i32* %p, align 4, !dbg !41
+  ret i32 %v, !dbg !41
+}
+
+define dso_local i32 @f(i32 %n) !dbg !12 {
+entry:
+  %n.addr = alloca i32, align 4
+  %s = alloca i32, align 4
+  %k = alloca i32, align 4
+  %i = alloca i32, align 4
+  store i32 %n, i32* %n.addr, align 4
+  call void @llvm.dbg.declare(metadata i32* %n.addr, metadata !16, metadata !DIExpression()), !dbg !17
+  call void @llvm.dbg.declare(metadata i32* %s, metadata !18, metadata !DIExpression()), !dbg !19
+  store i32 0, i32* %s, align 4, !dbg !19
+  call void @llvm.dbg.declare(metadata i32* %k, metadata !20, metadata !DIExpression()), !dbg !21
+  store i32 3, i32* %k, align 4, !dbg !21
+  call void @llvm.dbg.declare(metadata i32* %i, metadata !22, metadata !DIExpression()), !dbg !23
+  store i32 0, i32* %i, align 4, !dbg !23
+  br label %for.cond, !dbg !24
+
+for.cond:
+  %0 = load i32, i32* %i, align 4, !dbg !25
+  %1 = load i32, i32* %n.addr, align 4, !dbg !25
+  %cmp = icmp slt i32 %0, %1, !dbg !25
+  br i1 %cmp, label %for.body, label %for.end, !dbg !24
+
+for.body:
+  %2 = load i32, i32* %i, align 4, !dbg !26
+  %idxprom = sext i32 %2 to i64, !dbg !26
+  %arrayidx = getelementptr inbounds [100 x i32], [100 x i32]* @tab, i64 0, i64 %idxprom, !dbg !26
+  %3 = load i32, i32* %arrayidx, align 4, !dbg !26
+  %4 = load i32, i32* %k, align 4, !dbg !26
+  %5 = load i32, i32* %k, align 4, !dbg !26
+  %6 = load i32, i32* @cfg, align 4, !dbg !26
+  %add = add nsw i32 %3, %4, !dbg !26
+  %add2 = add nsw i32 %add, %5, !dbg !26
+  %add3 = add nsw i32 %add2, %6, !dbg !26
+  %7 = load i32, i32* %s, align 4, !dbg !26
+  %add1 = add nsw i32 %7, %add3, !dbg !26
+  store i32 %add1, i32* %s, align 4, !dbg !26
+  %h = call i32 @helper(i32* %k), !dbg !26
+  br label %for.inc, !dbg !26
+
+for.inc:
+  %8 = load i32, i32* %i, align 4, !dbg !27
+  %inc = add nsw i32 %8, 1, !dbg !27
+  store i32 %inc, i32* %i, align 4, !dbg !27
+  br label %for.cond, !dbg !27
+
+for.end:
+  %9 = load i32, i32* %s, align 4, !dbg !28
+  ret i32 %9, !dbg !28
+}
+
+declare void @llvm.dbg.declare(metadata, metadata, metadata)
+
+!llvm.dbg.cu = !{!2}
+!llvm.module.flags = !{!8, !9}
+
+!0 = !DIGlobalVariableExpression(var: !1, expr: !DIExpression())
+!1 = distinct !DIGlobalVariable(name: "tab", scope: !2, file: !3, line: 1, type: !6, isLocal: false, isDefinition: true)
+!2 = distinct !DICompileUnit(language: DW_LANG_C99, file: !3, producer: "clang", isOptimized: false, runtimeVersion: 0, emissionKind: FullDebug, globals: !5)
+!3 = !DIFile(filename: "loop.c", directory: "/tmp")
+!4 = !{}
+!5 = !{!0, !30}
+!6 = !DICompositeType(tag: DW_TAG_array_type, baseType: !7, size: 3200, elements: !4)
+!7 = !DIBasicType(name: "int", size: 32, encoding: DW_ATE_signed)
+!8 = !{i32 2, !"Dwarf Version", i32 4}
+!9 = !{i32 2, !"Debug Info Version", i32 3}
+!12 = distinct !DISubprogram(name: "f", scope: !3, file: !3, line: 3, type: !13, scopeLine: 3, spFlags: DISPFlagDefinition, unit: !2, retainedNodes: !4)
+!13 = !DISubroutineType(types: !14)
+!14 = !{!7, !7}
+!16 = !DILocalVariable(name: "n", arg: 1, scope: !12, file: !3, line: 3, type: !7)
+!17 = !DILocation(line: 3, column: 11, scope: !12)
+!18 = !DILocalVariable(name: "s", scope: !12, file: !3, line: 4, type: !7)
+!19 = !DILocation(line: 4, column: 7, scope: !12)
+!20 = !DILocalVariable(name: "k", scope: !12, file: !3, line: 5, type: !7)
+!21 = !DILocation(line: 5, column: 7, scope: !12)
+!22 = !DILocalVariable(name: "i", scope: !12, file: !3, line: 6, type: !7)
+!23 = !DILocation(line: 6, column: 12, scope: !12)
+!24 = !DILocation(line: 6, column: 3, scope: !12)
+!25 = !DILocation(line: 6, column: 19, scope: !12)
+!26 = !DILocation(line: 7, column: 7, scope: !12)
+!27 = !DILocation(line: 6, column: 25, scope: !12)
+!28 = !DILocation(line: 9, column: 3, scope: !12)
+!30 = !DIGlobalVariableExpression(var: !31, expr: !DIExpression())
+!31 = distinct !DIGlobalVariable(name: "cfg", scope: !2, file: !3, line: 2, type: !7, isLocal: false, isDefinition: true)
+!40 = distinct !DISubprogram(name: "helper", scope: !3, file: !3, line: 11, type: !13, scopeLine: 11, spFlags: DISPFlagDefinition, unit: !2, retainedNodes: !4)
+!41 = !DILocation(line: 11, column: 3, scope: !40)
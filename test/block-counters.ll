@@ -0,0 +1,79 @@
+; -instrumentBlockCounters: every function gets its own counter array, which
+; is internal unless the function is an ODR function, and a module constructor
+; registers the arrays with the profiler runtime.
+;
+;   1  int ext(void) { int x = 1;
+;   2                  return x; }
+;   3  inline int inl(void) { int x = 1;
+;   4                         return x; }
+
+; RUN: rm -rf %t && mkdir -p %t
+; RUN: %depanalysis -instrumentBlockCounters -depOutputDir=%t -S %s -o %t/out.ll
+; RUN: FileCheck %s < %t/out.ll
+; RUN: FileCheck %s --check-prefix=EXT < %t/ext_blockdeps.txt
+; RUN: FileCheck %s --check-prefix=INL < %t/inl_blockdeps.txt
+
+; CHECK:     $inl = comdat any
+; CHECK:     @llvm.global_ctors = appending global {{.*}} @__dep_register_block_counters_ctor
+; CHECK-DAG: @__dep_block_counters_ext = internal global [1 x i64] zeroinitializer
+; CHECK-DAG: @__dep_block_counters_inl = linkonce_odr global [1 x i64] zeroinitializer, comdat($inl)
+
+; The increments have no debug location, so DiscoPoP doesn't instrument them
+; CHECK-LABEL: define dso_local i32 @ext()
+; CHECK-NEXT:  entry:
+; CHECK-NEXT:    [[C:%.*]] = load i64, i64* getelementptr inbounds ([1 x i64], [1 x i64]* @__dep_block_counters_ext, i64 0, i64 0){{(, align 8)?$}}
+; CHECK-NEXT:    [[I:%.*]] = add i64 [[C]], 1{{$}}
+; CHECK-NEXT:    store i64 [[I]], i64* getelementptr inbounds ([1 x i64], [1 x i64]* @__dep_block_counters_ext, i64 0, i64 0){{(, align 8)?$}}
+
+; CHECK-LABEL: define internal void @__dep_register_block_counters_ctor()
+; CHECK-DAG:   call void @__dep_register_block_counters({{.*}}, i64* getelementptr inbounds ([1 x i64], [1 x i64]* @__dep_block_counters_ext, i64 0, i64 0), i64 1)
+; CHECK-DAG:   call void @__dep_register_block_counters({{.*}}, i64* getelementptr inbounds ([1 x i64], [1 x i64]* @__dep_block_counters_inl, i64 0, i64 0), i64 1)
+; CHECK:       ret void
+; CHECK:       declare void @__dep_register_block_counters(i8*, i64*, i64)
+
+; EXT: counters|__dep_block_counters_ext|1
+; INL: counters|__dep_block_counters_inl|1
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+$inl = comdat any
+
+define dso_local i32 @ext() !dbg !10 {
+entry:
+  %x = alloca i32, align 4
+  call void @llvm.dbg.declare(metadata i32* %x, metadata !11, metadata !DIExpression()), !dbg !12
+  store i32 1, i32* %x, align 4, !dbg !12
+  %0 = load i32, i32* %x, align 4, !dbg !13
+  ret i32 %0, !dbg !13
+}
+
+define linkonce_odr dso_local i32 @inl() comdat !dbg !20 {
+entry:
+  %x = alloca i32, align 4
+  call void @llvm.dbg.declare(metadata i32* %x, metadata !21, metadata !DIExpression()), !dbg !22
+  store i32 1, i32* %x, align 4, !dbg !22
+  %0 = load i32, i32* %x, align 4, !dbg !23
+  ret i32 %0, !dbg !23
+}
+
+declare void @llvm.dbg.declare(metadata, metadata, metadata)
+
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!2, !3}
+
+!0 = distinct !DICompileUnit(language: DW_LANG_C99, file: !1, producer: "clang", isOptimized: false, runtimeVersion: 0, emissionKind: FullDebug)
+!1 = !DIFile(filename: "block-counters.c", directory: "/tmp")
+!2 = !{i32 2, !"Dwarf Version", i32 4}
+!3 = !{i32 2, !"Debug Info Version", i32 3}
+!4 = !DIBasicType(name: "int", size: 32, encoding: DW_ATE_signed)
+!5 = !DISubroutineType(types: !6)
+!6 = !{!4}
+!10 = distinct !DISubprogram(name: "ext", scope: !1, file: !1, line: 1, type: !5, scopeLine: 1, spFlags: DISPFlagDefinition, unit: !0)
+!11 = !DILocalVariable(name: "x", scope: !10, file: !1, line: 1, type: !4)
+!12 = !DILocation(line: 1, column: 21, scope: !10)
+!13 = !DILocation(line: 2, column: 19, scope: !10)
+!20 = distinct !DISubprogram(name: "inl", scope: !1, file: !1, line: 3, type: !5, scopeLine: 3, spFlags: DISPFlagDefinition, unit: !0)
+!21 = !DILocalVariable(name: "x", scope: !20, file: !1, line: 3, type: !4)
+!22 = !DILocation(line: 3, column: 28, scope: !20)
+!23 = !DILocation(line: 4, column: 26, scope: !20)
@@ -0,0 +1,17 @@
+; Per-function results are cached in -depCacheDir. A second run with the same
+; context reuses them, and changing an option that affects the results does
+; not.
+
+; RUN: rm -rf %t && mkdir -p %t/out %t/cache
+; RUN: %depanalysis -disable-output -depOutputDir=%t/out -depCacheDir=%t/cache -depStatsJson=%t/first.json -depDumpResults=%t/first.txt %S/Inputs/loop.ll
+; RUN: FileCheck %s --check-prefix=MISS < %t/first.json
+; RUN: %depanalysis -disable-output -depOutputDir=%t/out -depCacheDir=%t/cache -depStatsJson=%t/second.json -depDumpResults=%t/second.txt %S/Inputs/loop.ll
+; RUN: FileCheck %s --check-prefix=HIT < %t/second.json
+; RUN: diff %t/first.txt %t/second.txt
+; RUN: %depanalysis -disable-output -depOutputDir=%t/out -depCacheDir=%t/cache -depStatsJson=%t/other.json -omitLoopIndependent %S/Inputs/loop.ll
+; RUN: FileCheck %s --check-prefix=MISS < %t/other.json
+
+; MISS:     "cached":false
+; MISS-NOT: "cached":true
+; HIT:      "cached":true
+; HIT-NOT:  "cached":false
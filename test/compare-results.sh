@@ -0,0 +1,46 @@
+#!/bin/sh
+# Compares the results of two builds of the DepAnalysis plugin on the sample
+# inputs, e.g. before and after a change that should not affect them:
+#
+#   test/compare-results.sh old/LLVMDepAnalysis.so new/LLVMDepAnalysis.so
+#
+# Further arguments replace the inputs (default: test/Inputs/*.ll). opt is
+# taken from $OPT or the PATH, and $OPT_FLAGS is passed on to it. Prints the
+# differences of the -depDumpResults files and exits with 1 if there are any.
+
+if [ $# -lt 2 ]; then
+	echo "usage: $0 <old plugin> <new plugin> [inputs...]" >&2
+	exit 2
+fi
+old=$1
+new=$2
+shift 2
+if [ $# -eq 0 ]; then
+	set -- "$(dirname "$0")"/Inputs/*.ll
+fi
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+# run <plugin> <input> <results file>
+run()
+{
+	mkdir -p "$work/out"
+	if ! ${OPT:-opt} $OPT_FLAGS -load "$1" -dep-analysis -disable-output -depOutputDir="$work/out" -depDumpResults="$3" "$2" > "$work/log" 2>&1; then
+		echo "opt failed with $1 on $2:" >&2
+		cat "$work/log" >&2
+		return 1
+	fi
+}
+
+status=0
+for input in "$@"; do
+	name=$(basename "$input" .ll)
+	run "$old" "$input" "$work/old.txt" && run "$new" "$input" "$work/new.txt" || { status=1; continue; }
+	if diff -u -L "$name (old)" -L "$name (new)" "$work/old.txt" "$work/new.txt"; then
+		echo "same $name"
+	else
+		status=1
+	fi
+done
+exit $status
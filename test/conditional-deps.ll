@@ -0,0 +1,24 @@
+; Dependences that hold whenever a block executes are reported per block, in
+; the results and in <function>_blockdeps.txt.
+
+; RUN: rm -rf %t && mkdir -p %t
+; RUN: %depanalysis -disable-output -depOutputDir=%t -depDumpResults=%t/results.txt %S/Inputs/loop.ll
+; RUN: FileCheck %s < %t/results.txt
+; RUN: FileCheck %s --check-prefix=BLOCKS < %t/f_blockdeps.txt
+
+; CHECK:      f|cond|entry|6 NOM  RAW 6|i
+; CHECK-NEXT: f|cond|entry|7 NOM  RAW 4|s
+; CHECK-NEXT: f|cond|entry|7 NOM  RAW 5|k
+; CHECK-NEXT: f|cond|entry|7 NOM  RAW 6|i
+; CHECK-NEXT: f|cond|entry|9 NOM  RAW 4|s
+; CHECK-NEXT: f|cond|for.body|7 NOM  RAW 5|k
+; CHECK-NOT:  |cond|
+
+; Without -instrumentBlockCounters there is no counter array
+; BLOCKS:      counters||2
+; BLOCKS-NEXT: 0|entry|6 NOM  RAW 6|i
+; BLOCKS-NEXT: 0|entry|7 NOM  RAW 4|s
+; BLOCKS-NEXT: 0|entry|7 NOM  RAW 5|k
+; BLOCKS-NEXT: 0|entry|7 NOM  RAW 6|i
+; BLOCKS-NEXT: 0|entry|9 NOM  RAW 4|s
+; BLOCKS-NEXT: 1|for.body|7 NOM  RAW 5|k
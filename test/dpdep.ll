@@ -0,0 +1,31 @@
+; The dependences in the DiscoPoP format (PDG::getDPDepMap), in the results
+; and written by -depExport, optionally merged with a dynamic profile.
+
+; RUN: rm -rf %t && mkdir -p %t
+; RUN: %depanalysis -disable-output -depOutputDir=%t -depDumpResults=%t/results.txt -depExport=%t/deps.txt %S/Inputs/loop.ll
+; RUN: FileCheck %s < %t/results.txt
+; RUN: FileCheck %s --check-prefix=EXPORT --match-full-lines < %t/deps.txt
+; RUN: %depanalysis -disable-output -depOutputDir=%t -depExport=%t/merged.txt -depExportMerge=%S/Inputs/loop-profile.txt %S/Inputs/loop.ll
+; RUN: FileCheck %s --check-prefix=MERGED --match-full-lines < %t/merged.txt
+
+; CHECK:      f|dpdep|1:6|RAW 1:6|i
+; CHECK-NEXT: f|dpdep|1:6|WAR 1:6|i
+; CHECK-NEXT: f|dpdep|1:7|RAW 1:4|s
+; CHECK-NEXT: f|dpdep|1:7|RAW 1:5|k
+; CHECK-NEXT: f|dpdep|1:7|RAW 1:6|i
+; CHECK-NEXT: f|dpdep|1:7|RAW 1:7|s
+; CHECK-NEXT: f|dpdep|1:7|WAR 1:7|s
+; CHECK-NEXT: f|dpdep|1:9|RAW 1:4|s
+; CHECK-NEXT: f|dpdep|1:9|RAW 1:7|s
+; CHECK-NOT:  |dpdep|
+
+; EXPORT:      1:6 NOM  RAW 1:6|i WAR 1:6|i
+; EXPORT-NEXT: 1:7 NOM  RAW 1:4|s RAW 1:5|k RAW 1:6|i RAW 1:7|s WAR 1:7|s
+; EXPORT-NEXT: 1:9 NOM  RAW 1:4|s RAW 1:7|s
+; EXPORT-NOT:  {{.}}
+
+; Dependences found by both are listed once, lines are in numeric order
+; MERGED:      1:6 NOM  RAW 1:6|i WAR 1:6|i
+; MERGED-NEXT: 1:7 NOM  RAW 1:4|s RAW 1:5|k RAW 1:6|i RAW 1:7|s WAR 1:7|s WAW 1:7|tab
+; MERGED-NEXT: 1:9 NOM  RAW 1:4|s RAW 1:7|s
+; MERGED-NEXT: 1:11 NOM  RAW 1:11|p
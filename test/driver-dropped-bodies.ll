@@ -0,0 +1,58 @@
+; dep-analysis-driver drops the bodies of the functions that are not selected.
+; Their writes are not visible anymore, so only constant globals are read-only.
+;
+;   1  static int g = 1; static const int c = 2;
+;   2  void set(int v) { g = v; }
+;   3  int get(void) { return g + c; }
+
+; RUN: rm -rf %t && mkdir -p %t
+; RUN: dep-analysis-driver -depFunctions=get -depOutputDir=%t -depDumpResults=%t/get.txt %s
+; RUN: FileCheck %s < %t/get.txt
+; RUN: dep-analysis-driver -depOutputDir=%t -depDumpResults=%t/all.txt %s
+; RUN: FileCheck %s < %t/all.txt
+
+; CHECK-NOT: |g|readonly-global
+; CHECK:     get|omit|3:22|r|c|readonly-global
+; CHECK-NOT: |g|readonly-global
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+@g = internal global i32 1, align 4, !dbg !0
+@c = internal constant i32 2, align 4
+
+define dso_local void @set(i32 %v) !dbg !12 {
+entry:
+  store i32 %v, i32* @g, align 4, !dbg !17
+  ret void, !dbg !17
+}
+
+define dso_local i32 @get() !dbg !20 {
+entry:
+  %v = load i32, i32* @g, align 4, !dbg !21
+  %w = load i32, i32* @c, align 4, !dbg !24
+  %r = add nsw i32 %v, %w, !dbg !21
+  ret i32 %r, !dbg !21
+}
+
+!llvm.dbg.cu = !{!2}
+!llvm.module.flags = !{!8, !9}
+
+!0 = !DIGlobalVariableExpression(var: !1, expr: !DIExpression())
+!1 = distinct !DIGlobalVariable(name: "g", scope: !2, file: !3, line: 1, type: !7, isLocal: true, isDefinition: true)
+!2 = distinct !DICompileUnit(language: DW_LANG_C99, file: !3, producer: "clang", isOptimized: false, runtimeVersion: 0, emissionKind: FullDebug, globals: !5)
+!3 = !DIFile(filename: "driver-dropped-bodies.c", directory: "/tmp")
+!4 = !{}
+!5 = !{!0}
+!7 = !DIBasicType(name: "int", size: 32, encoding: DW_ATE_signed)
+!8 = !{i32 2, !"Dwarf Version", i32 4}
+!9 = !{i32 2, !"Debug Info Version", i32 3}
+!12 = distinct !DISubprogram(name: "set", scope: !3, file: !3, line: 2, type: !13, scopeLine: 2, spFlags: DISPFlagDefinition, unit: !2, retainedNodes: !4)
+!13 = !DISubroutineType(types: !14)
+!14 = !{null, !7}
+!17 = !DILocation(line: 2, column: 20, scope: !12)
+!20 = distinct !DISubprogram(name: "get", scope: !3, file: !3, line: 3, type: !22, scopeLine: 3, spFlags: DISPFlagDefinition, unit: !2, retainedNodes: !4)
+!21 = !DILocation(line: 3, column: 18, scope: !20)
+!22 = !DISubroutineType(types: !23)
+!23 = !{!7}
+!24 = !DILocation(line: 3, column: 22, scope: !20)
@@ -0,0 +1,80 @@
+; RAW, WAR and WAW dependence edges, loop-carried ones are marked with *.
+;
+;   1  int e(void) {
+;   2    int x = 1;
+;   3    x = 2;
+;   4    int y = x;
+;   5    x = y;
+;   6    return x + y;
+;   7  }
+
+; RUN: rm -rf %t && mkdir -p %t
+; RUN: %depanalysis -disable-output -depOutputDir=%t -depDumpResults=%t/results.txt %s
+; RUN: FileCheck %s < %t/results.txt
+; RUN: %depanalysis -disable-output -depOutputDir=%t -depDumpResults=%t/loop.txt %S/Inputs/loop.ll
+; RUN: FileCheck %s --check-prefix=LOOP < %t/loop.txt
+
+; Edges go from the later access to the earlier one it depends on. The
+; search stops at the first access of a path, so x = y only depends on the
+; read of x before it, not on the write on line 3.
+; CHECK:      e|edge|3:5|w|x|WAW|2:7|w|x
+; CHECK-NEXT: e|edge|4:11|r|x|RAW|3:5|w|x
+; CHECK-NEXT: e|edge|5:5|w|x|WAR|4:11|r|x
+; CHECK-NEXT: e|edge|5:7|r|y|RAW|4:7|w|y
+; CHECK-NEXT: e|edge|6:10|r|x|RAW|5:5|w|x
+; CHECK-NEXT: e|edge|6:14|r|y|RAW|4:7|w|y
+; CHECK-NOT:  e|edge
+
+; LOOP:      f|edge|6:19|r|i|RAW*|6:25|w|i
+; LOOP-NEXT: f|edge|6:19|r|i|RAW|6:12|w|i
+; LOOP:      f|edge|6:25|w|i|WAR*|6:25|r|i
+; LOOP:      f|edge|7:7|r|s|RAW*|7:7|w|s
+; LOOP-NEXT: f|edge|7:7|r|s|RAW|4:7|w|s
+; LOOP-NEXT: f|edge|7:7|w|s|WAR*|7:7|r|s
+; LOOP-NEXT: f|edge|9:3|r|s|RAW|4:7|w|s
+; LOOP-NEXT: f|edge|9:3|r|s|RAW|7:7|w|s
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+define dso_local i32 @e() !dbg !10 {
+entry:
+  %x = alloca i32, align 4
+  %y = alloca i32, align 4
+  call void @llvm.dbg.declare(metadata i32* %x, metadata !14, metadata !DIExpression()), !dbg !15
+  store i32 1, i32* %x, align 4, !dbg !15
+  store i32 2, i32* %x, align 4, !dbg !16
+  call void @llvm.dbg.declare(metadata i32* %y, metadata !17, metadata !DIExpression()), !dbg !18
+  %0 = load i32, i32* %x, align 4, !dbg !19
+  store i32 %0, i32* %y, align 4, !dbg !18
+  %1 = load i32, i32* %y, align 4, !dbg !20
+  store i32 %1, i32* %x, align 4, !dbg !21
+  %2 = load i32, i32* %x, align 4, !dbg !22
+  %3 = load i32, i32* %y, align 4, !dbg !23
+  %add = add nsw i32 %2, %3, !dbg !22
+  ret i32 %add, !dbg !22
+}
+
+declare void @llvm.dbg.declare(metadata, metadata, metadata)
+
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!2, !3}
+
+!0 = distinct !DICompileUnit(language: DW_LANG_C99, file: !1, producer: "clang", isOptimized: false, runtimeVersion: 0, emissionKind: FullDebug)
+!1 = !DIFile(filename: "edges.c", directory: "/tmp")
+!2 = !{i32 2, !"Dwarf Version", i32 4}
+!3 = !{i32 2, !"Debug Info Version", i32 3}
+!4 = !DIBasicType(name: "int", size: 32, encoding: DW_ATE_signed)
+!5 = !DISubroutineType(types: !6)
+!6 = !{!4}
+!10 = distinct !DISubprogram(name: "e", scope: !1, file: !1, line: 1, type: !5, scopeLine: 1, spFlags: DISPFlagDefinition, unit: !0)
+!14 = !DILocalVariable(name: "x", scope: !10, file: !1, line: 2, type: !4)
+!15 = !DILocation(line: 2, column: 7, scope: !10)
+!16 = !DILocation(line: 3, column: 5, scope: !10)
+!17 = !DILocalVariable(name: "y", scope: !10, file: !1, line: 4, type: !4)
+!18 = !DILocation(line: 4, column: 7, scope: !10)
+!19 = !DILocation(line: 4, column: 11, scope: !10)
+!20 = !DILocation(line: 5, column: 7, scope: !10)
+!21 = !DILocation(line: 5, column: 5, scope: !10)
+!22 = !DILocation(line: 6, column: 10, scope: !10)
+!23 = !DILocation(line: 6, column: 14, scope: !10)
@@ -0,0 +1,19 @@
+; -depCheckGolden compares the results with a golden file and fails the run,
+; listing the differences, if they don't match.
+
+; RUN: rm -rf %t && mkdir -p %t
+; RUN: %depanalysis -disable-output -depOutputDir=%t -depCheckGolden=%S/Inputs/loop.golden %S/Inputs/loop.ll
+
+; A golden file with one missing and one stale line
+; RUN: sed -e '/f|omit|6:19|r|n|local/d' %S/Inputs/loop.golden > %t/stale.golden
+; RUN: echo 'f|omit|6:3|r|n|local' >> %t/stale.golden
+; RUN: not %depanalysis -disable-output -depOutputDir=%t -depCheckGolden=%t/stale.golden %S/Inputs/loop.ll 2>&1 | FileCheck %s
+
+; CHECK:      Results differ from {{.*}}stale.golden:
+; CHECK-NEXT: -f|omit|6:3|r|n|local
+; CHECK-NEXT: +f|omit|6:19|r|n|local
+; CHECK-NEXT: LLVM ERROR: DepAnalysis regression check failed
+
+; RUN: not %depanalysis -disable-output -depOutputDir=%t -depCheckGolden=%t/missing.golden %S/Inputs/loop.ll 2>&1 | FileCheck %s --check-prefix=MISSING
+; MISSING: Problem opening golden file: {{.*}}missing.golden
+; MISSING: LLVM ERROR: DepAnalysis regression check failed
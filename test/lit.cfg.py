@@ -0,0 +1,33 @@
+# -*- Python -*-
+
+# Configuration file for the DepAnalysis regression tests, see CMakeLists.txt
+
+import os
+import re
+import subprocess
+
+import lit.formats
+
+config.name = 'DepAnalysis'
+config.test_format = lit.formats.ShTest(True)
+config.suffixes = ['.ll']
+config.excludes = ['Inputs']
+
+config.test_source_root = os.path.dirname(__file__)
+config.test_exec_root = config.depanalysis_obj_root
+
+config.environment['PATH'] = os.path.pathsep.join((config.llvm_tools_dir, config.environment['PATH']))
+
+plugin = os.path.join(config.llvm_shlib_dir, 'LLVMDepAnalysis' + config.llvm_shlib_ext)
+opt = os.path.join(config.llvm_tools_dir, 'opt')
+
+# The passes are legacy passes, which opt only runs by default up to LLVM 12
+opt_flags = ''
+version = subprocess.check_output([opt, '--version']).decode()
+match = re.search(r'LLVM version (\d+)', version)
+if match and int(match.group(1)) >= 13:
+    opt_flags = ' -enable-new-pm=0'
+
+# %opt_plugin for the analyses of the plugin, %depanalysis for the pass
+config.substitutions.append(('%opt_plugin', '%s%s -load %s' % (opt, opt_flags, plugin)))
+config.substitutions.append(('%depanalysis', '%s%s -load %s -dep-analysis' % (opt, opt_flags, plugin)))
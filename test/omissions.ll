@@ -0,0 +1,186 @@
+; Every omission reason: accesses without debug location, of locals that don't
+; escape, conditional and redundant accesses, reads of read-only globals and
+; locals without loop-carried dependences (-omitLoopIndependent).
+;
+;   1  int tab[100];
+;   2  static int cfg = 7;
+;   3  int f(int n) {
+;   4    int s = 0;
+;   5    int k = 3;
+;   6    for (int i = 0; i < n; i++)
+;   7      s += tab[i] + k + k + cfg + ctab[i] + helper(&k);
+;   8
+;   9    return s;
+;  10  }
+;  11  int helper(int *p) { return *p; }
+;  12  void li(int n) {
+;  13    int a[100];
+;  14    for (int i = 0; i < n; i++) {
+;  15      a[i] = i;
+;  16      use(a[i]);
+;  17    }
+;  18  }
+
+; RUN: rm -rf %t && mkdir -p %t
+; RUN: %depanalysis -disable-output -depOutputDir=%t -depDumpResults=%t/results.txt %s
+; RUN: FileCheck %s --check-prefixes=CHECK,DEFAULT < %t/results.txt
+; RUN: %depanalysis -disable-output -depOutputDir=%t -depDumpResults=%t/li.txt -omitLoopIndependent %s
+; RUN: FileCheck %s --check-prefixes=CHECK,LOOPINDEP < %t/li.txt
+
+; The results are sorted. tab is external and may be written elsewhere, so
+; only the reads of cfg and ctab are omitted as read-only.
+; CHECK:      f|omit|4:7|w|s|conditional
+; CHECK-NEXT: f|omit|5:7|w|k|conditional
+; CHECK-NEXT: f|omit|6:12|w|i|conditional
+; CHECK-NEXT: f|omit|6:19|r|n|local
+; CHECK-NEXT: f|omit|6:25|r|i|redundant
+; CHECK-NEXT: f|omit|7:7|r|cfg|readonly-global
+; CHECK-NEXT: f|omit|7:7|r|ctab[i]|readonly-global
+; CHECK-NEXT: f|omit|7:7|r|i|redundant
+; CHECK-NEXT: f|omit|7:7|r|k|conditional
+; CHECK-NEXT: f|omit|7:7|r|k|conditional
+; CHECK-NEXT: f|omit|INIT|w|n|nodbg
+; CHECK-NEXT: f|redundant|6:25|r|i|6:19
+; CHECK-NEXT: f|redundant|7:7|r|i|6:19
+
+; a[i] is only written and read in the same iteration
+; DEFAULT-NOT:    li|omit
+; LOOPINDEP:      li|omit|15:10|w|a[i]|loop-independent
+; LOOPINDEP-NEXT: li|omit|16:9|r|a[i]|loop-independent
+
+source_filename = "omissions.c"
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+@tab = dso_local global [100 x i32] zeroinitializer, align 16, !dbg !0
+@cfg = internal global i32 7, align 4, !dbg !30
+@ctab = dso_local constant [4 x i32] [i32 1, i32 2, i32 3, i32 4], align 4
+
+define dso_local i32 @helper(i32* %p) !dbg !40 {
+entry:
+  %v = load i32, i32* %p, align 4, !dbg !41
+  ret i32 %v, !dbg !41
+}
+
+define dso_local i32 @f(i32 %n) !dbg !12 {
+entry:
+  %n.addr = alloca i32, align 4
+  %s = alloca i32, align 4
+  %k = alloca i32, align 4
+  %i = alloca i32, align 4
+  store i32 %n, i32* %n.addr, align 4
+  call void @llvm.dbg.declare(metadata i32* %n.addr, metadata !16, metadata !DIExpression()), !dbg !17
+  call void @llvm.dbg.declare(metadata i32* %s, metadata !18, metadata !DIExpression()), !dbg !19
+  store i32 0, i32* %s, align 4, !dbg !19
+  call void @llvm.dbg.declare(metadata i32* %k, metadata !20, metadata !DIExpression()), !dbg !21
+  store i32 3, i32* %k, align 4, !dbg !21
+  call void @llvm.dbg.declare(metadata i32* %i, metadata !22, metadata !DIExpression()), !dbg !23
+  store i32 0, i32* %i, align 4, !dbg !23
+  br label %for.cond, !dbg !24
+
+for.cond:
+  %0 = load i32, i32* %i, align 4, !dbg !25
+  %1 = load i32, i32* %n.addr, align 4, !dbg !25
+  %cmp = icmp slt i32 %0, %1, !dbg !25
+  br i1 %cmp, label %for.body, label %for.end, !dbg !24
+
+for.body:
+  %2 = load i32, i32* %i, align 4, !dbg !26
+  %idxprom = sext i32 %2 to i64, !dbg !26
+  %arrayidx = getelementptr inbounds [100 x i32], [100 x i32]* @tab, i64 0, i64 %idxprom, !dbg !26
+  %3 = load i32, i32* %arrayidx, align 4, !dbg !26
+  %4 = load i32, i32* %k, align 4, !dbg !26
+  %5 = load i32, i32* %k, align 4, !dbg !26
+  %6 = load i32, i32* @cfg, align 4, !dbg !26
+  %ct = getelementptr inbounds [4 x i32], [4 x i32]* @ctab, i64 0, i64 %idxprom, !dbg !26
+  %ctv = load i32, i32* %ct, align 4, !dbg !26
+  %add = add nsw i32 %3, %4, !dbg !26
+  %add2 = add nsw i32 %add, %5, !dbg !26
+  %add3 = add nsw i32 %add2, %6, !dbg !26
+  %7 = load i32, i32* %s, align 4, !dbg !26
+  %add1 = add nsw i32 %7, %add3, !dbg !26
+  store i32 %add1, i32* %s, align 4, !dbg !26
+  %h = call i32 @helper(i32* %k), !dbg !26
+  br label %for.inc, !dbg !26
+
+for.inc:
+  %8 = load i32, i32* %i, align 4, !dbg !27
+  %inc = add nsw i32 %8, 1, !dbg !27
+  store i32 %inc, i32* %i, align 4, !dbg !27
+  br label %for.cond, !dbg !27
+
+for.end:
+  %9 = load i32, i32* %s, align 4, !dbg !28
+  ret i32 %9, !dbg !28
+}
+
+define dso_local void @li(i32 %n) !dbg !50 {
+entry:
+  %a = alloca [100 x i32], align 16
+  call void @llvm.dbg.declare(metadata [100 x i32]* %a, metadata !57, metadata !DIExpression()), !dbg !58
+  br label %for.cond
+
+for.cond:
+  %i = phi i32 [ 0, %entry ], [ %inc, %for.body ]
+  %cmp = icmp slt i32 %i, %n, !dbg !51
+  br i1 %cmp, label %for.body, label %for.end, !dbg !51
+
+for.body:
+  %idx = sext i32 %i to i64
+  %p = getelementptr inbounds [100 x i32], [100 x i32]* %a, i64 0, i64 %idx, !dbg !52
+  store i32 %i, i32* %p, align 4, !dbg !52
+  %v = load i32, i32* %p, align 4, !dbg !53
+  call void @use(i32 %v), !dbg !53
+  %inc = add nsw i32 %i, 1, !dbg !51
+  br label %for.cond, !dbg !51
+
+for.end:
+  ret void, !dbg !54
+}
+
+declare void @use(i32)
+
+declare void @llvm.dbg.declare(metadata, metadata, metadata)
+
+!llvm.dbg.cu = !{!2}
+!llvm.module.flags = !{!8, !9}
+
+!0 = !DIGlobalVariableExpression(var: !1, expr: !DIExpression())
+!1 = distinct !DIGlobalVariable(name: "tab", scope: !2, file: !3, line: 1, type: !6, isLocal: false, isDefinition: true)
+!2 = distinct !DICompileUnit(language: DW_LANG_C99, file: !3, producer: "clang", isOptimized: false, runtimeVersion: 0, emissionKind: FullDebug, globals: !5)
+!3 = !DIFile(filename: "omissions.c", directory: "/tmp")
+!4 = !{}
+!5 = !{!0, !30}
+!6 = !DICompositeType(tag: DW_TAG_array_type, baseType: !7, size: 3200, elements: !4)
+!7 = !DIBasicType(name: "int", size: 32, encoding: DW_ATE_signed)
+!8 = !{i32 2, !"Dwarf Version", i32 4}
+!9 = !{i32 2, !"Debug Info Version", i32 3}
+!12 = distinct !DISubprogram(name: "f", scope: !3, file: !3, line: 3, type: !13, scopeLine: 3, spFlags: DISPFlagDefinition, unit: !2, retainedNodes: !4)
+!13 = !DISubroutineType(types: !14)
+!14 = !{!7, !7}
+!16 = !DILocalVariable(name: "n", arg: 1, scope: !12, file: !3, line: 3, type: !7)
+!17 = !DILocation(line: 3, column: 11, scope: !12)
+!18 = !DILocalVariable(name: "s", scope: !12, file: !3, line: 4, type: !7)
+!19 = !DILocation(line: 4, column: 7, scope: !12)
+!20 = !DILocalVariable(name: "k", scope: !12, file: !3, line: 5, type: !7)
+!21 = !DILocation(line: 5, column: 7, scope: !12)
+!22 = !DILocalVariable(name: "i", scope: !12, file: !3, line: 6, type: !7)
+!23 = !DILocation(line: 6, column: 12, scope: !12)
+!24 = !DILocation(line: 6, column: 3, scope: !12)
+!25 = !DILocation(line: 6, column: 19, scope: !12)
+!26 = !DILocation(line: 7, column: 7, scope: !12)
+!27 = !DILocation(line: 6, column: 25, scope: !12)
+!28 = !DILocation(line: 9, column: 3, scope: !12)
+!30 = !DIGlobalVariableExpression(var: !31, expr: !DIExpression())
+!31 = distinct !DIGlobalVariable(name: "cfg", scope: !2, file: !3, line: 2, type: !7, isLocal: false, isDefinition: true)
+!40 = distinct !DISubprogram(name: "helper", scope: !3, file: !3, line: 11, type: !13, scopeLine: 11, spFlags: DISPFlagDefinition, unit: !2, retainedNodes: !4)
+!41 = !DILocation(line: 11, column: 3, scope: !40)
+!50 = distinct !DISubprogram(name: "li", scope: !3, file: !3, line: 12, type: !55, scopeLine: 12, spFlags: DISPFlagDefinition, unit: !2, retainedNodes: !4)
+!51 = !DILocation(line: 14, column: 21, scope: !50)
+!52 = !DILocation(line: 15, column: 10, scope: !50)
+!53 = !DILocation(line: 16, column: 9, scope: !50)
+!54 = !DILocation(line: 18, column: 1, scope: !50)
+!55 = !DISubroutineType(types: !56)
+!56 = !{null, !7}
+!57 = !DILocalVariable(name: "a", scope: !50, file: !3, line: 13, type: !6)
+!58 = !DILocation(line: 13, column: 7, scope: !50)
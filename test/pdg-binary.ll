@@ -0,0 +1,54 @@
+; Binary PDGs read back with PDGBinaryReader (pdg-dump).
+
+; After removals the file holds the same nodes and edges as the live graph,
+; and the slots of the erased and replaced nodes are kept as placeholders.
+; RUN: rm -rf %t && mkdir -p %t
+; RUN: pdg-update-test -function=all %S/pdg-update.ll -o %t/all.pdg > %t/all.txt
+; RUN: pdg-dump %t/all.pdg > %t/all.dump
+; RUN: FileCheck %s --check-prefix=UPDATED < %t/all.dump
+; RUN: grep -e '^node' -e '^edge' %t/all.txt > %t/live.txt
+; RUN: grep -v removed %t/all.dump > %t/kept.txt
+; RUN: diff %t/live.txt %t/kept.txt
+
+; UPDATED:      node 0 entry 0:0 -
+; UPDATED-NEXT: node 1 exit 0:0 -
+; UPDATED-NEXT: node 2 write 2:6 p
+; UPDATED-NEXT: node 3 removed
+; UPDATED-NEXT: node 4 removed
+; UPDATED-NEXT: node 5 write 5:6 p
+; UPDATED-NEXT: node 6 read 4:11 p
+; UPDATED-NEXT: node 7 write 6:6 q
+; UPDATED-DAG:  edge 2 6 CTR
+; UPDATED-DAG:  edge 6 2 RAW
+; UPDATED-DAG:  edge 5 6 WAR
+
+; Graphs of the pass (-dumpBinary)
+; RUN: %depanalysis -disable-output -dumpBinary -depOutputDir=%t %S/Inputs/loop.ll
+; RUN: pdg-dump %t/f_cfg.pdg | FileCheck %s --check-prefix=CFG
+; RUN: pdg-dump %t/f_deps.pdg | FileCheck %s --check-prefix=DEPS
+
+; CFG:      node 0 entry 0:0 -
+; CFG-NEXT: node 1 exit 0:0 -
+; CFG-NEXT: node [[DECL:[0-9]+]] declare 3:11 n.addr
+; CFG-NOT:  removed
+; CFG:      node [[INIT:[0-9]+]] write 4:7 s highlighted
+; CFG-NOT:  removed
+; CFG:      edge [[DECL]] {{[0-9]+}} CTR
+
+; DEPS:     node [[COND:[0-9]+]] read 6:19 i
+; DEPS:     node [[INC:[0-9]+]] write 6:25 i
+; DEPS:     edge [[COND]] [[INC]] RAW*
+
+; Files that are not binary PDGs, or whose edges or strings point outside of
+; the file, are rejected. all.pdg has 8 nodes, 8 edges and 3 strings: the
+; first edge ends at byte 188 and the first string offset is at byte 280.
+; RUN: not pdg-dump %S/Inputs/loop.golden 2>&1 | FileCheck %s --check-prefix=INVALID
+; RUN: head -c 100 %t/all.pdg > %t/truncated.pdg
+; RUN: not pdg-dump %t/truncated.pdg 2>&1 | FileCheck %s --check-prefix=INVALID
+; RUN: cp %t/all.pdg %t/bad-edge.pdg
+; RUN: printf 'c' | dd of=%t/bad-edge.pdg bs=1 seek=188 conv=notrunc 2>/dev/null
+; RUN: not pdg-dump %t/bad-edge.pdg 2>&1 | FileCheck %s --check-prefix=INVALID
+; RUN: cp %t/all.pdg %t/bad-string.pdg
+; RUN: printf 'c' | dd of=%t/bad-string.pdg bs=1 seek=280 conv=notrunc 2>/dev/null
+; RUN: not pdg-dump %t/bad-string.pdg 2>&1 | FileCheck %s --check-prefix=INVALID
+; INVALID: Not a valid binary PDG of version 2:
@@ -0,0 +1,215 @@
+; Incremental PDG updates after trackUpdates(): the graph follows erased and
+; RAUW'd accesses through their update handles, and insertInstruction()
+; splices an access into the store/load CFG. pdg-update-test builds the
+; graph with same-pointer dependences and applies the updates given by the
+; !pdg.erase, !pdg.rauw and !pdg.insert metadata.
+;
+;   1  void f(int *p, int *q) {
+;   2    *p = 1;
+;   3    *q = 2;
+;   4    int a = *p;
+;   5    *p = a;
+;   6    *q = 3;
+;   7  }
+
+; RUN: pdg-update-test -function=plain %s | FileCheck %s --check-prefix=PLAIN --implicit-check-not=edge
+; RUN: pdg-update-test -function=erase %s | FileCheck %s --check-prefix=ERASE --implicit-check-not=edge
+; RUN: pdg-update-test -function=rauw %s | FileCheck %s --check-prefix=RAUW --implicit-check-not=edge
+; RUN: pdg-update-test -function=insert %s | FileCheck %s --check-prefix=INSERT --implicit-check-not=edge
+; RUN: pdg-update-test -function=all %s | FileCheck %s --check-prefix=ALL --implicit-check-not=edge
+; RUN: pdg-update-test -function=alone %s | FileCheck %s --check-prefix=ALONE --implicit-check-not=edge
+
+; PLAIN:      node 0 entry
+; PLAIN-NEXT: node 1 exit
+; PLAIN-NEXT: node 2 write 2:6 p
+; PLAIN-NEXT: node 3 write 3:6 q
+; PLAIN-NEXT: node 4 read 4:11 p
+; PLAIN-NEXT: node 5 write 5:6 p
+; PLAIN-NEXT: node 6 write 6:6 q
+; PLAIN-DAG:  edge 0 2 CTR
+; PLAIN-DAG:  edge 2 3 CTR
+; PLAIN-DAG:  edge 3 4 CTR
+; PLAIN-DAG:  edge 4 5 CTR
+; PLAIN-DAG:  edge 5 6 CTR
+; PLAIN-DAG:  edge 6 1 CTR
+; PLAIN-DAG:  edge 4 2 RAW
+; PLAIN-DAG:  edge 5 2 WAW
+; PLAIN-DAG:  edge 5 4 WAR
+; PLAIN-DAG:  edge 6 3 WAW
+
+; Erasing *q = 2 drops its node and WAW edge, its CTR neighbours are bridged
+; ERASE:      erase 3
+; ERASE-NOT:  node 3
+; ERASE:      node 4 read 4:11 p
+; ERASE-DAG:  edge 0 2 CTR
+; ERASE-DAG:  edge 2 4 CTR
+; ERASE-DAG:  edge 4 5 CTR
+; ERASE-DAG:  edge 5 6 CTR
+; ERASE-DAG:  edge 6 1 CTR
+; ERASE-DAG:  edge 4 2 RAW
+; ERASE-DAG:  edge 5 2 WAW
+; ERASE-DAG:  edge 5 4 WAR
+
+; The copy replacing the load takes over all edges of its node
+; RAUW:       rauw 4 7
+; RAUW-NOT:   node 4
+; RAUW:       node 7 read 4:11 p
+; RAUW-DAG:   edge 0 2 CTR
+; RAUW-DAG:   edge 2 3 CTR
+; RAUW-DAG:   edge 3 7 CTR
+; RAUW-DAG:   edge 7 5 CTR
+; RAUW-DAG:   edge 5 6 CTR
+; RAUW-DAG:   edge 6 1 CTR
+; RAUW-DAG:   edge 7 2 RAW
+; RAUW-DAG:   edge 5 2 WAW
+; RAUW-DAG:   edge 5 7 WAR
+; RAUW-DAG:   edge 6 3 WAW
+
+; *q = 3 is put back after *p = a, which passes its exit edge on
+; INSERT:     insert 6
+; INSERT:     node 6 write 6:6 q
+; INSERT-DAG: edge 0 2 CTR
+; INSERT-DAG: edge 2 3 CTR
+; INSERT-DAG: edge 3 4 CTR
+; INSERT-DAG: edge 4 5 CTR
+; INSERT-DAG: edge 5 6 CTR
+; INSERT-DAG: edge 6 1 CTR
+; INSERT-DAG: edge 4 2 RAW
+; INSERT-DAG: edge 5 2 WAW
+; INSERT-DAG: edge 5 4 WAR
+; INSERT-DAG: edge 6 3 WAW
+
+; ALL:        erase 3
+; ALL-NEXT:   rauw 4 6
+; ALL-NEXT:   insert 7
+; ALL-NEXT:   node 0 entry
+; ALL-NEXT:   node 1 exit
+; ALL-NEXT:   node 2 write 2:6 p
+; ALL-NEXT:   node 5 write 5:6 p
+; ALL-NEXT:   node 6 read 4:11 p
+; ALL-NEXT:   node 7 write 6:6 q
+; ALL-DAG:    edge 0 2 CTR
+; ALL-DAG:    edge 2 6 CTR
+; ALL-DAG:    edge 6 5 CTR
+; ALL-DAG:    edge 5 7 CTR
+; ALL-DAG:    edge 7 1 CTR
+; ALL-DAG:    edge 6 2 RAW
+; ALL-DAG:    edge 5 2 WAW
+; ALL-DAG:    edge 5 6 WAR
+
+; Without another graph instruction in its block the graph has to be rebuilt
+; ALONE:      insert rebuild
+; ALONE-NOT:  node 3
+; ALONE-DAG:  edge 0 2 CTR
+; ALONE-DAG:  edge 2 1 CTR
+
+define void @plain(i32* %p, i32* %q) !dbg !20 {
+entry:
+  store i32 1, i32* %p, align 4, !dbg !21
+  store i32 2, i32* %q, align 4, !dbg !22
+  %a = load i32, i32* %p, align 4, !dbg !23
+  store i32 %a, i32* %p, align 4, !dbg !24
+  store i32 3, i32* %q, align 4, !dbg !25
+  ret void, !dbg !26
+}
+
+define void @erase(i32* %p, i32* %q) !dbg !27 {
+entry:
+  store i32 1, i32* %p, align 4, !dbg !28
+  store i32 2, i32* %q, align 4, !dbg !29, !pdg.erase !4
+  %a = load i32, i32* %p, align 4, !dbg !30
+  store i32 %a, i32* %p, align 4, !dbg !31
+  store i32 3, i32* %q, align 4, !dbg !32
+  ret void, !dbg !33
+}
+
+define void @rauw(i32* %p, i32* %q) !dbg !34 {
+entry:
+  store i32 1, i32* %p, align 4, !dbg !35
+  store i32 2, i32* %q, align 4, !dbg !36
+  %a = load i32, i32* %p, align 4, !dbg !37, !pdg.rauw !4
+  store i32 %a, i32* %p, align 4, !dbg !38
+  store i32 3, i32* %q, align 4, !dbg !39
+  ret void, !dbg !40
+}
+
+define void @insert(i32* %p, i32* %q) !dbg !41 {
+entry:
+  store i32 1, i32* %p, align 4, !dbg !42
+  store i32 2, i32* %q, align 4, !dbg !43
+  %a = load i32, i32* %p, align 4, !dbg !44
+  store i32 %a, i32* %p, align 4, !dbg !45
+  store i32 3, i32* %q, align 4, !dbg !46, !pdg.insert !4
+  ret void, !dbg !47
+}
+
+define void @all(i32* %p, i32* %q) !dbg !48 {
+entry:
+  store i32 1, i32* %p, align 4, !dbg !49
+  store i32 2, i32* %q, align 4, !dbg !50, !pdg.erase !4
+  %a = load i32, i32* %p, align 4, !dbg !51, !pdg.rauw !4
+  store i32 %a, i32* %p, align 4, !dbg !52
+  store i32 3, i32* %q, align 4, !dbg !53, !pdg.insert !4
+  ret void, !dbg !54
+}
+
+define void @alone(i32* %p, i1 %c) !dbg !55 {
+entry:
+  store i32 1, i32* %p, align 4, !dbg !56
+  br i1 %c, label %then, label %end, !dbg !56
+
+then:
+  store i32 2, i32* %p, align 4, !dbg !57, !pdg.insert !4
+  br label %end, !dbg !57
+
+end:
+  ret void, !dbg !57
+}
+
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!2, !3}
+
+!0 = distinct !DICompileUnit(language: DW_LANG_C99, file: !1, producer: "clang", isOptimized: false, runtimeVersion: 0, emissionKind: FullDebug)
+!1 = !DIFile(filename: "pdg-update.c", directory: "/tmp")
+!2 = !{i32 2, !"Dwarf Version", i32 4}
+!3 = !{i32 2, !"Debug Info Version", i32 3}
+!4 = !{}
+!5 = !DISubroutineType(types: !4)
+!20 = distinct !DISubprogram(name: "plain", scope: !1, file: !1, line: 1, type: !5, scopeLine: 1, spFlags: DISPFlagDefinition, unit: !0, retainedNodes: !4)
+!21 = !DILocation(line: 2, column: 6, scope: !20)
+!22 = !DILocation(line: 3, column: 6, scope: !20)
+!23 = !DILocation(line: 4, column: 11, scope: !20)
+!24 = !DILocation(line: 5, column: 6, scope: !20)
+!25 = !DILocation(line: 6, column: 6, scope: !20)
+!26 = !DILocation(line: 7, column: 1, scope: !20)
+!27 = distinct !DISubprogram(name: "erase", scope: !1, file: !1, line: 1, type: !5, scopeLine: 1, spFlags: DISPFlagDefinition, unit: !0, retainedNodes: !4)
+!28 = !DILocation(line: 2, column: 6, scope: !27)
+!29 = !DILocation(line: 3, column: 6, scope: !27)
+!30 = !DILocation(line: 4, column: 11, scope: !27)
+!31 = !DILocation(line: 5, column: 6, scope: !27)
+!32 = !DILocation(line: 6, column: 6, scope: !27)
+!33 = !DILocation(line: 7, column: 1, scope: !27)
+!34 = distinct !DISubprogram(name: "rauw", scope: !1, file: !1, line: 1, type: !5, scopeLine: 1, spFlags: DISPFlagDefinition, unit: !0, retainedNodes: !4)
+!35 = !DILocation(line: 2, column: 6, scope: !34)
+!36 = !DILocation(line: 3, column: 6, scope: !34)
+!37 = !DILocation(line: 4, column: 11, scope: !34)
+!38 = !DILocation(line: 5, column: 6, scope: !34)
+!39 = !DILocation(line: 6, column: 6, scope: !34)
+!40 = !DILocation(line: 7, column: 1, scope: !34)
+!41 = distinct !DISubprogram(name: "insert", scope: !1, file: !1, line: 1, type: !5, scopeLine: 1, spFlags: DISPFlagDefinition, unit: !0, retainedNodes: !4)
+!42 = !DILocation(line: 2, column: 6, scope: !41)
+!43 = !DILocation(line: 3, column: 6, scope: !41)
+!44 = !DILocation(line: 4, column: 11, scope: !41)
+!45 = !DILocation(line: 5, column: 6, scope: !41)
+!46 = !DILocation(line: 6, column: 6, scope: !41)
+!47 = !DILocation(line: 7, column: 1, scope: !41)
+!48 = distinct !DISubprogram(name: "all", scope: !1, file: !1, line: 1, type: !5, scopeLine: 1, spFlags: DISPFlagDefinition, unit: !0, retainedNodes: !4)
+!49 = !DILocation(line: 2, column: 6, scope: !48)
+!50 = !DILocation(line: 3, column: 6, scope: !48)
+!51 = !DILocation(line: 4, column: 11, scope: !48)
+!52 = !DILocation(line: 5, column: 6, scope: !48)
+!53 = !DILocation(line: 6, column: 6, scope: !48)
+!54 = !DILocation(line: 7, column: 1, scope: !48)
+!55 = distinct !DISubprogram(name: "alone", scope: !1, file: !1, line: 1, type: !5, scopeLine: 1, spFlags: DISPFlagDefinition, unit: !0, retainedNodes: !4)
+!56 = !DILocation(line: 2, column: 6, scope: !55)
+!57 = !DILocation(line: 3, column: 13, scope: !55)
@@ -0,0 +1,22 @@
+; -depPerfMaxSeconds and -depPerfMaxQueries fail the run if the analysis of the
+; module takes longer or needs more DependenceAnalysis queries.
+;
+; The regression gate is the query count: it does not depend on the machine,
+; so the passing run pins it to the 125 queries Inputs/loop.ll needs today and
+; any analysis change that issues more of them fails here. Update the limit
+; when such a change is intended. Wall-clock times of a function this small
+; say nothing, the seconds limit is only checked in its failing mode; time the
+; scaling with dep-analysis-bench -benchMaxSlope instead.
+
+; RUN: rm -rf %t && mkdir -p %t
+; RUN: %depanalysis -disable-output -depOutputDir=%t -depPerfMaxQueries=125 %S/Inputs/loop.ll
+; RUN: not %depanalysis -disable-output -depOutputDir=%t -depPerfMaxQueries=124 %S/Inputs/loop.ll 2>&1 | FileCheck %s --check-prefix=QUERIES
+; RUN: not %depanalysis -disable-output -depOutputDir=%t -depPerfMaxSeconds=1e-9 %S/Inputs/loop.ll 2>&1 | FileCheck %s --check-prefix=SECONDS
+
+; QUERIES:     Analysis needed 125 DA queries, limit is 124
+; QUERIES-NOT: Analysis took
+; QUERIES:     LLVM ERROR: DepAnalysis regression check failed
+
+; SECONDS:     Analysis took {{.*}}s, limit is 1{{.*}}s
+; SECONDS-NOT: DA queries
+; SECONDS:     LLVM ERROR: DepAnalysis regression check failed
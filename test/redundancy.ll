@@ -0,0 +1,46 @@
+; Repeated reads of an address are omitted while the value is still available.
+; A write never leads a group: the read after it has to be instrumented for
+; the profiler to see its RAW dependence, and then leads the following reads.
+;
+;   1  int g;
+;   2  int f(int n) { g = n;
+;   3                 int a = g;
+;   4                 int b = g;
+;   5                 return a + b; }
+
+; RUN: rm -rf %t && mkdir -p %t
+; RUN: %depanalysis -disable-output -depOutputDir=%t -depDumpResults=%t/results.txt %s
+; RUN: FileCheck %s < %t/results.txt
+
+; CHECK-NOT:  f|omit|2:3
+; CHECK-NOT:  f|omit|3:3
+; CHECK:      f|omit|4:3|r|g|redundant
+; CHECK-NEXT: f|redundant|4:3|r|g|3:3
+; CHECK-NOT:  f|redundant
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+@g = dso_local global i32 0, align 4
+
+define dso_local i32 @f(i32 %n) !dbg !10 {
+entry:
+  store i32 %n, i32* @g, align 4, !dbg !11
+  %a = load i32, i32* @g, align 4, !dbg !12
+  %b = load i32, i32* @g, align 4, !dbg !13
+  %s = add i32 %a, %b
+  ret i32 %s
+}
+
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!2, !3}
+!0 = distinct !DICompileUnit(language: DW_LANG_C99, file: !1, producer: "clang", isOptimized: false, runtimeVersion: 0, emissionKind: FullDebug)
+!1 = !DIFile(filename: "redundancy.c", directory: "/tmp")
+!2 = !{i32 2, !"Dwarf Version", i32 4}
+!3 = !{i32 2, !"Debug Info Version", i32 3}
+!4 = !DISubroutineType(types: !5)
+!5 = !{null}
+!10 = distinct !DISubprogram(name: "f", scope: !1, file: !1, line: 1, type: !4, scopeLine: 1, spFlags: DISPFlagDefinition, unit: !0)
+!11 = !DILocation(line: 2, column: 3, scope: !10)
+!12 = !DILocation(line: 3, column: 3, scope: !10)
+!13 = !DILocation(line: 4, column: 3, scope: !10)
@@ -0,0 +1,10 @@
+; The sample inputs still give their golden results (loop.ll is checked in
+; golden.ll). After an intended change, the goldens are regenerated with
+; -depDumpResults. compare-results.sh lists how two builds of the plugin
+; differ on the samples.
+
+; RUN: rm -rf %t && mkdir -p %t
+; RUN: %depanalysis -disable-output -depOutputDir=%t -depCheckGolden=%S/Inputs/loop-nocall.golden %S/Inputs/loop-nocall.ll
+; RUN: %depanalysis -disable-output -depOutputDir=%t -depCheckGolden=%S/Inputs/loop-promoted.golden %S/Inputs/loop-promoted.ll
+; RUN: %depanalysis -disable-output -depOutputDir=%t -depCheckGolden=%S/Inputs/loop-readonly-arg.golden %S/Inputs/loop-readonly-arg.ll
+; RUN: %depanalysis -disable-output -depOutputDir=%t -depCheckGolden=%S/Inputs/loop-internal-global.golden %S/Inputs/loop-internal-global.ll
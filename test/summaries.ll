@@ -0,0 +1,170 @@
+; A call only ends the availability of a read if the callee's summary says it
+; may write the address. Writes through invokes and atomics are part of the
+; summaries.
+;
+;   1  int g, h, u;
+;   2  void w(void) { atomic_fetch_add(&g, 1); }
+;   3  void x(void) { u = 1; }
+;   4  void v(void) { try { x(); } catch (...) {} }
+;   5  int r(void) {
+;   6    int a = g; w(); a += g;
+;   7    a += u; v(); a += u;
+;   8    a += h; w(); a += h;
+;   9    return a; }
+;  10  int *saved;
+;  11  int get(int *p) { return *p; }
+;  12  void set(int *p) { p[1] = 1; }
+;  13  void keep(int *p) { saved = p; }
+;  14  int l(void) {
+;  15    int k[2];
+;  16    int a = h; set(k); a += h;
+;  17    return a + get(k); }
+;
+; get, set and keep are compiled with -O0, which spills p to %p.addr. Loads
+; of such a slot are copies of the argument, so get only reads and set only
+; writes through p; keep still captures it.
+
+; RUN: rm -rf %t && mkdir -p %t
+; RUN: %depanalysis -disable-output -depOutputDir=%t -depDumpResults=%t/results.txt %s
+; RUN: FileCheck %s < %t/results.txt
+; RUN: %opt_plugin -function-summary -analyze %s | FileCheck %s --check-prefix=SUMMARY
+
+; In l the second read of h is redundant, set only writes k
+; CHECK-NOT:  redundant
+; CHECK:      l|omit|16:28|r|h|redundant
+; CHECK-NEXT: l|redundant|16:28|r|h|16:11
+; In r only the second read of h is
+; CHECK-NEXT: r|omit|8:16|r|h|redundant
+; CHECK-NEXT: r|redundant|8:16|r|h|8:8
+; CHECK-NOT:  redundant
+
+; SUMMARY:      get:
+; SUMMARY-NEXT:   arg 0: read{{$}}
+; SUMMARY-NEXT: set:
+; SUMMARY-NEXT:   arg 0: written{{$}}
+; SUMMARY-NEXT: keep:
+; SUMMARY-NEXT:   arg 0: captured{{$}}
+; SUMMARY-NEXT:   write saved
+; SUMMARY-NEXT: l:
+; SUMMARY-NEXT:   read h
+; SUMMARY-NEXT: read-only globals:
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+@g = dso_local global i32 0, align 4
+@h = dso_local global i32 0, align 4
+@u = dso_local global i32 0, align 4
+@saved = dso_local global i32* null, align 8
+
+define dso_local void @w() {
+entry:
+  %old = atomicrmw add i32* @g, i32 1 seq_cst
+  ret void
+}
+
+define dso_local void @x() {
+entry:
+  store i32 1, i32* @u, align 4
+  ret void
+}
+
+define dso_local void @v() personality i32 (...)* @__gxx_personality_v0 {
+entry:
+  invoke void @x()
+          to label %done unwind label %lpad
+
+lpad:
+  %lp = landingpad { i8*, i32 }
+          catch i8* null
+  br label %done
+
+done:
+  ret void
+}
+
+define dso_local i32 @r() !dbg !10 {
+entry:
+  %0 = load i32, i32* @g, align 4, !dbg !11
+  call void @w(), !dbg !11
+  %1 = load i32, i32* @g, align 4, !dbg !12
+  %2 = load i32, i32* @u, align 4, !dbg !13
+  call void @v(), !dbg !13
+  %3 = load i32, i32* @u, align 4, !dbg !14
+  %4 = load i32, i32* @h, align 4, !dbg !15
+  call void @w(), !dbg !15
+  %5 = load i32, i32* @h, align 4, !dbg !16
+  %a1 = add nsw i32 %0, %1
+  %a2 = add nsw i32 %a1, %2
+  %a3 = add nsw i32 %a2, %3
+  %a4 = add nsw i32 %a3, %4
+  %a5 = add nsw i32 %a4, %5
+  ret i32 %a5, !dbg !17
+}
+
+define dso_local i32 @get(i32* %p) {
+entry:
+  %p.addr = alloca i32*, align 8
+  store i32* %p, i32** %p.addr, align 8
+  %0 = load i32*, i32** %p.addr, align 8
+  %1 = load i32, i32* %0, align 4
+  ret i32 %1
+}
+
+define dso_local void @set(i32* %p) {
+entry:
+  %p.addr = alloca i32*, align 8
+  store i32* %p, i32** %p.addr, align 8
+  %0 = load i32*, i32** %p.addr, align 8
+  %arrayidx = getelementptr inbounds i32, i32* %0, i64 1
+  store i32 1, i32* %arrayidx, align 4
+  ret void
+}
+
+define dso_local void @keep(i32* %p) {
+entry:
+  %p.addr = alloca i32*, align 8
+  store i32* %p, i32** %p.addr, align 8
+  %0 = load i32*, i32** %p.addr, align 8
+  store i32* %0, i32** @saved, align 8
+  ret void
+}
+
+define dso_local i32 @l() !dbg !20 {
+entry:
+  %k = alloca [2 x i32], align 4
+  %0 = load i32, i32* @h, align 4, !dbg !21
+  %arraydecay = getelementptr inbounds [2 x i32], [2 x i32]* %k, i64 0, i64 0, !dbg !22
+  call void @set(i32* %arraydecay), !dbg !22
+  %1 = load i32, i32* @h, align 4, !dbg !23
+  %arraydecay1 = getelementptr inbounds [2 x i32], [2 x i32]* %k, i64 0, i64 0, !dbg !24
+  %call = call i32 @get(i32* %arraydecay1), !dbg !24
+  %a1 = add nsw i32 %0, %1
+  %a2 = add nsw i32 %a1, %call
+  ret i32 %a2, !dbg !24
+}
+
+declare i32 @__gxx_personality_v0(...)
+
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!2, !3}
+
+!0 = distinct !DICompileUnit(language: DW_LANG_C_plus_plus, file: !1, producer: "clang", isOptimized: false, runtimeVersion: 0, emissionKind: FullDebug)
+!1 = !DIFile(filename: "summaries.cpp", directory: "/tmp")
+!2 = !{i32 2, !"Dwarf Version", i32 4}
+!3 = !{i32 2, !"Debug Info Version", i32 3}
+!4 = !DISubroutineType(types: !5)
+!5 = !{null}
+!10 = distinct !DISubprogram(name: "r", scope: !1, file: !1, line: 5, type: !4, scopeLine: 5, spFlags: DISPFlagDefinition, unit: !0)
+!11 = !DILocation(line: 6, column: 11, scope: !10)
+!12 = !DILocation(line: 6, column: 24, scope: !10)
+!13 = !DILocation(line: 7, column: 8, scope: !10)
+!14 = !DILocation(line: 7, column: 21, scope: !10)
+!15 = !DILocation(line: 8, column: 8, scope: !10)
+!16 = !DILocation(line: 8, column: 16, scope: !10)
+!17 = !DILocation(line: 9, column: 3, scope: !10)
+!20 = distinct !DISubprogram(name: "l", scope: !1, file: !1, line: 14, type: !4, scopeLine: 14, spFlags: DISPFlagDefinition, unit: !0)
+!21 = !DILocation(line: 16, column: 11, scope: !20)
+!22 = !DILocation(line: 16, column: 14, scope: !20)
+!23 = !DILocation(line: 16, column: 28, scope: !20)
+!24 = !DILocation(line: 17, column: 14, scope: !20)
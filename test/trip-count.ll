@@ -0,0 +1,152 @@
+; Trip counts of the loops of loop-invariant accesses: blocks that also run in
+; the iteration leaving the loop run once more than the backedge is taken,
+; the whole body if the latch exits, only the header if the header exits.
+; Counts that don't fit the type and loops without a single latch are counted
+; at runtime ("?").
+
+; RUN: rm -rf %t && mkdir -p %t
+; RUN: %depanalysis -disable-output -depOutputDir=%t -depDumpResults=%t/results.txt %s
+; RUN: FileCheck %s < %t/results.txt
+
+; CHECK: eight|loopinv|3:5|r|g|?|8
+; CHECK: header|loopinv|42:23|r|g|?|9
+; CHECK: header|loopinv|43:16|r|g|?|8
+; CHECK: symbolic|loopinv|32:5|r|g|?|{{.*}}%n
+; CHECK: twolatches|loopinv|22:5|r|g|?|?
+; CHECK: wrap|loopinv|12:5|r|g|?|?
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+@g = dso_local global i32 7, align 4
+@out = dso_local global i32 0, align 4
+
+; Rotated loop, 8 iterations: the latch exits, so the body runs BTC + 1 times
+define dso_local void @eight() !dbg !10 {
+entry:
+  br label %body
+
+body:
+  %i = phi i32 [ 0, %entry ], [ %inc, %body ]
+  %v = load i32, i32* @g, align 4, !dbg !11
+  %inc = add i32 %i, 1
+  %cmp = icmp ult i32 %inc, 8
+  br i1 %cmp, label %body, label %exit
+
+exit:
+  ret void
+}
+
+; i8 counter that wraps: the backedge is taken 255 times, the body runs 256
+; times, which doesn't fit i8
+define dso_local void @wrap() !dbg !20 {
+entry:
+  br label %body
+
+body:
+  %i = phi i8 [ 0, %entry ], [ %inc, %body ]
+  %v = load i32, i32* @g, align 4, !dbg !21
+  %inc = add i8 %i, 1
+  %cmp = icmp ne i8 %inc, 0
+  br i1 %cmp, label %body, label %exit
+
+exit:
+  ret void
+}
+
+; Two latches
+define dso_local void @twolatches(i1 %c) !dbg !30 {
+entry:
+  br label %head
+
+head:
+  %i = phi i32 [ 0, %entry ], [ %inc, %a ], [ %inc, %b ]
+  %v = load i32, i32* @g, align 4, !dbg !31
+  %inc = add i32 %i, 1
+  %done = icmp uge i32 %inc, 8
+  br i1 %done, label %exit, label %split
+
+split:
+  br i1 %c, label %a, label %b
+
+a:
+  br label %head
+
+b:
+  br label %head
+
+exit:
+  ret void
+}
+
+; Guarded rotated loop of n iterations
+define dso_local void @symbolic(i32 %n) !dbg !40 {
+entry:
+  %guard = icmp sgt i32 %n, 0
+  br i1 %guard, label %body, label %exit
+
+body:
+  %i = phi i32 [ 0, %entry ], [ %inc, %body ]
+  %v = load i32, i32* @g, align 4, !dbg !41
+  %inc = add nsw i32 %i, 1
+  %cmp = icmp slt i32 %inc, %n
+  br i1 %cmp, label %body, label %exit
+
+exit:
+  ret void
+}
+
+; The for.cond loop of -O0 code after mem2reg, without rotation. The header
+; exits, so it runs 9 times for 8 iterations of the body:
+;
+;  40  void header(void) {
+;  41    int v;
+;  42    for (int i = 0; v = g, i < 8; i++)
+;  43      out += v + g;
+;  44  }
+define dso_local void @header() !dbg !50 {
+entry:
+  br label %for.cond
+
+for.cond:
+  %i = phi i32 [ 0, %entry ], [ %inc, %for.inc ]
+  %v = load i32, i32* @g, align 4, !dbg !51
+  %cmp = icmp slt i32 %i, 8
+  br i1 %cmp, label %for.body, label %for.end
+
+for.body:
+  %w = load i32, i32* @g, align 4, !dbg !52
+  %o = load i32, i32* @out, align 4, !dbg !53
+  %s = add nsw i32 %v, %w
+  %add = add nsw i32 %o, %s
+  store i32 %add, i32* @out, align 4, !dbg !53
+  br label %for.inc
+
+for.inc:
+  %inc = add nsw i32 %i, 1
+  br label %for.cond
+
+for.end:
+  ret void
+}
+
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!2, !3}
+!0 = distinct !DICompileUnit(language: DW_LANG_C99, file: !1, producer: "clang", isOptimized: false, runtimeVersion: 0, emissionKind: FullDebug)
+!1 = !DIFile(filename: "trip.c", directory: "/tmp")
+!2 = !{i32 2, !"Dwarf Version", i32 4}
+!3 = !{i32 2, !"Debug Info Version", i32 3}
+!4 = !DISubroutineType(types: !5)
+!5 = !{null}
+!10 = distinct !DISubprogram(name: "eight", scope: !1, file: !1, line: 1, type: !4, scopeLine: 1, spFlags: DISPFlagDefinition, unit: !0)
+!11 = !DILocation(line: 3, column: 5, scope: !10)
+!20 = distinct !DISubprogram(name: "wrap", scope: !1, file: !1, line: 10, type: !4, scopeLine: 10, spFlags: DISPFlagDefinition, unit: !0)
+!21 = !DILocation(line: 12, column: 5, scope: !20)
+!30 = distinct !DISubprogram(name: "twolatches", scope: !1, file: !1, line: 20, type: !4, scopeLine: 20, spFlags: DISPFlagDefinition, unit: !0)
+!31 = !DILocation(line: 22, column: 5, scope: !30)
+!40 = distinct !DISubprogram(name: "symbolic", scope: !1, file: !1, line: 30, type: !4, scopeLine: 30, spFlags: DISPFlagDefinition, unit: !0)
+!41 = !DILocation(line: 32, column: 5, scope: !40)
+!50 = distinct !DISubprogram(name: "header", scope: !1, file: !1, line: 40, type: !4, scopeLine: 40, spFlags: DISPFlagDefinition, unit: !0)
+!51 = !DILocation(line: 42, column: 23, scope: !50)
+!52 = !DILocation(line: 43, column: 16, scope: !50)
+!53 = !DILocation(line: 43, column: 9, scope: !50)